@@ -0,0 +1,422 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <stdio.h>
+
+#include <entt/entt.hpp>
+#include <vec/vec.hpp>
+
+#include "random.hpp"
+#include "tilemap.hpp"
+#include "pathfinding.hpp"
+#include "entity_common.hpp"
+#include "battle_map.hpp"
+#include "overworld_generation.hpp"
+#include "movingai.hpp"
+
+///deterministic maps from fixed seeds, batches of queries through a_star, and every answer checked against a plain dijkstra
+///run with "quick" to skip the 2048x2048 maps, or "movingai file.map file.scen" to replay a MovingAI benchmark instead
+///run from the repo root, the vendored MovingAI sample is loaded from bench/movingai
+
+struct bench_map
+{
+    std::string name;
+    entt::registry registry;
+    entt::entity map = entt::null;
+    tilemap* tmap = nullptr;
+};
+
+struct engine
+{
+    const char* name;
+    path_mode::type mode;
+    ///exact engines have to match dijkstra, the rest just get their worst ratio reported
+    bool exact;
+};
+
+///same step costs as expand_search, so a path's cost is directly comparable
+double path_cost_of(const tilemap& tmap, const std::vector<vec2i>& path)
+{
+    double total = 0;
+
+    for(int i = 1; i < (int)path.size(); i++)
+    {
+        vec2i diff = path[i] - path[i - 1];
+
+        total += (diff.x() != 0 && diff.y() != 0) ? M_SQRT2 : 1.;
+        total += tmap.path_cost[path[i].y() * tmap.dim.x() + path[i].x()];
+    }
+
+    return total;
+}
+
+bool path_is_walkable(const tilemap& tmap, const std::vector<vec2i>& path, vec2i start, vec2i fin)
+{
+    if(path.size() == 0 || path.front() != start || path.back() != fin)
+        return false;
+
+    for(int i = 0; i < (int)path.size(); i++)
+    {
+        vec2i pos = path[i];
+
+        if(pos.x() < 0 || pos.y() < 0 || pos.x() >= tmap.dim.x() || pos.y() >= tmap.dim.y())
+            return false;
+
+        if(i > 0 && tmap.path_cost[pos.y() * tmap.dim.x() + pos.x()] == -1)
+            return false;
+
+        if(i > 0)
+        {
+            vec2i diff = pos - path[i - 1];
+
+            if(abs(diff.x()) > 1 || abs(diff.y()) > 1 || (diff.x() == 0 && diff.y() == 0))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+///textbook dijkstra with nothing clever in it, the answer every engine gets checked against. -1 if fin can't be reached
+double reference_cost(const tilemap& tmap, vec2i start, vec2i fin)
+{
+    static const vec2i offsets[8] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+
+    int width = tmap.dim.x();
+    int fin_idx = fin.y() * width + fin.x();
+
+    std::vector<double> dist(tmap.dim.x() * tmap.dim.y(), -1);
+
+    using entry = std::pair<double, int>;
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry>> open;
+
+    dist[start.y() * width + start.x()] = 0;
+    open.push({0, start.y() * width + start.x()});
+
+    while(open.size() > 0)
+    {
+        auto [d, current] = open.top();
+        open.pop();
+
+        if(current == fin_idx)
+            return d;
+
+        if(d > dist[current])
+            continue;
+
+        vec2i pos = {current % width, current / width};
+
+        for(const vec2i& offset : offsets)
+        {
+            vec2i next = pos + offset;
+
+            if(next.x() < 0 || next.y() < 0 || next.x() >= tmap.dim.x() || next.y() >= tmap.dim.y())
+                continue;
+
+            int next_idx = next.y() * width + next.x();
+            int cost = tmap.path_cost[next_idx];
+
+            if(cost == -1)
+                continue;
+
+            double found = d + ((offset.x() != 0 && offset.y() != 0) ? M_SQRT2 : 1.) + cost;
+
+            if(dist[next_idx] != -1 && found >= dist[next_idx])
+                continue;
+
+            dist[next_idx] = found;
+            open.push({found, next_idx});
+        }
+    }
+
+    return -1;
+}
+
+///solid rocks at density percent of tiles, with a quarter of them swapped for brambles you can push through
+void make_battle_map(bench_map& bench, vec2i dim, int density, uint32_t seed)
+{
+    random_state rng;
+    rng.set_seed(seed);
+
+    bench.name = "battle " + std::to_string(dim.x()) + "x" + std::to_string(dim.y()) + " " + std::to_string(density) + "%";
+    bench.map = bench.registry.create();
+
+    tilemap tmap;
+    tmap.create(dim);
+
+    for(int y = 0; y < dim.y(); y++)
+    {
+        for(int x = 0; x < dim.x(); x++)
+        {
+            if(!(rand_det_s(rng.rng, 0, 100) < density))
+                continue;
+
+            bool weighted = rand_det_s(rng.rng, 0, 100) < 25;
+
+            tilemap_position transform;
+            transform.pos = {x, y};
+
+            sprite_handle handle = get_sprite_handle_of(rng, weighted ? tiles::BRAMBLE : tiles::ROCKS);
+
+            entt::entity obstacle = battle_map::create_obstacle(bench.registry, handle, transform, weighted ? 3 : -1);
+
+            tmap.add(bench.registry, obstacle, {x, y});
+        }
+    }
+
+    bench.registry.assign<tilemap>(bench.map, std::move(tmap));
+    bench.tmap = &bench.registry.get<tilemap>(bench.map);
+}
+
+void make_overworld_map(bench_map& bench, vec2i dim, uint32_t seed)
+{
+    random_state rng;
+    rng.set_seed(seed);
+
+    bench.name = "overworld " + std::to_string(dim.x()) + "x" + std::to_string(dim.y());
+    bench.map = create_overworld(bench.registry, rng, dim);
+    bench.tmap = &bench.registry.get<tilemap>(bench.map);
+}
+
+///pairs of distinct tiles that can reach each other, from a fixed seed
+std::vector<std::pair<vec2i, vec2i>> make_queries(tilemap& tmap, int num, uint32_t seed)
+{
+    random_state rng;
+    rng.set_seed(seed);
+
+    std::vector<vec2i> open_tiles;
+
+    for(int y = 0; y < tmap.dim.y(); y++)
+    {
+        for(int x = 0; x < tmap.dim.x(); x++)
+        {
+            if(tmap.path_cost[y * tmap.dim.x() + x] != -1)
+                open_tiles.push_back({x, y});
+        }
+    }
+
+    std::vector<std::pair<vec2i, vec2i>> ret;
+
+    if(open_tiles.size() < 2)
+        return ret;
+
+    for(int attempts = 0; (int)ret.size() < num && attempts < num * 100; attempts++)
+    {
+        int len = open_tiles.size();
+
+        vec2i start = open_tiles[clamp((int)rand_det_s(rng.rng, 0, len), 0, len - 1)];
+        vec2i fin = open_tiles[clamp((int)rand_det_s(rng.rng, 0, len), 0, len - 1)];
+
+        if(start == fin || !tmap.can_reach(start, fin))
+            continue;
+
+        ret.push_back({start, fin});
+    }
+
+    return ret;
+}
+
+///returns the number of mismatches from exact engines
+int run_map(bench_map& bench, const std::vector<engine>& engines, const std::vector<std::pair<vec2i, vec2i>>& queries)
+{
+    tilemap& tmap = *bench.tmap;
+
+    std::vector<double> reference;
+
+    for(auto& [start, fin] : queries)
+    {
+        reference.push_back(reference_cost(tmap, start, fin));
+    }
+
+    int mismatches = 0;
+
+    for(const engine& e : engines)
+    {
+        ///first query builds whatever lazy tables the engine wants, which isn't what's being measured
+        if(queries.size() > 0)
+            a_star(tmap, queries[0].first, queries[0].second, e.mode);
+
+        std::vector<double> ns;
+        uint64_t nodes = 0;
+        int engine_mismatches = 0;
+        double worst_ratio = 1;
+
+        for(int i = 0; i < (int)queries.size(); i++)
+        {
+            auto [start, fin] = queries[i];
+
+            uint64_t popped_before = tmap.search.open.num_popped;
+
+            auto then = std::chrono::steady_clock::now();
+
+            std::optional<std::vector<vec2i>> found = a_star(tmap, start, fin, e.mode);
+
+            auto now = std::chrono::steady_clock::now();
+
+            ns.push_back(std::chrono::duration<double, std::nano>(now - then).count());
+            nodes += tmap.search.open.num_popped - popped_before;
+
+            bool ok = found.has_value() && path_is_walkable(tmap, found.value(), start, fin);
+
+            if(!ok)
+            {
+                engine_mismatches++;
+                printf("  %s: no valid path %i %i -> %i %i, dijkstra says %f\n", e.name, start.x(), start.y(), fin.x(), fin.y(), reference[i]);
+                continue;
+            }
+
+            double cost = path_cost_of(tmap, found.value());
+            double best = reference[i];
+
+            worst_ratio = std::max(worst_ratio, cost / std::max(best, 1.));
+
+            if(e.exact && fabs(cost - best) > 1e-3 * std::max(best, 1.))
+            {
+                engine_mismatches++;
+                printf("  %s: %i %i -> %i %i costs %f, dijkstra says %f\n", e.name, start.x(), start.y(), fin.x(), fin.y(), cost, best);
+            }
+        }
+
+        double mean = 0;
+        double p99 = 0;
+
+        if(ns.size() > 0)
+        {
+            for(double v : ns)
+            {
+                mean += v;
+            }
+
+            mean /= ns.size();
+
+            std::sort(ns.begin(), ns.end());
+            p99 = ns[std::min((int)ns.size() - 1, (int)(ns.size() * 0.99))];
+        }
+
+        printf("%-22s %-10s %8i %12.0f %12.0f %12.0f %10.4f %6i\n", bench.name.c_str(), e.name, (int)queries.size(),
+               queries.size() > 0 ? (double)nodes / queries.size() : 0., mean, p99, worst_ratio, engine_mismatches);
+
+        if(e.exact)
+            mismatches += engine_mismatches;
+    }
+
+    return mismatches;
+}
+
+///replays a scenario file through every engine, on top of the usual dijkstra check
+///the scenario's expected lengths don't allow cutting corners and we do, so dijkstra has to come in at or under every one of them
+int run_movingai(const std::vector<engine>& engines, const std::string& map_file, const std::string& scen_file)
+{
+    random_state rng;
+
+    bench_map bench;
+    bench.name = map_file.substr(map_file.find_last_of("/\\") + 1);
+    bench.map = load_movingai_map(bench.registry, rng, map_file);
+    bench.tmap = &bench.registry.get<tilemap>(bench.map);
+
+    std::vector<movingai_scenario> scenarios = load_movingai_scenarios(scen_file);
+    std::vector<std::pair<vec2i, vec2i>> queries;
+
+    int over_expected = 0;
+    int cut_corners = 0;
+
+    for(const movingai_scenario& scen : scenarios)
+    {
+        if(scen.map_dim != bench.tmap->dim)
+            throw std::runtime_error("Scenario is for a " + std::to_string(scen.map_dim.x()) + "x" + std::to_string(scen.map_dim.y()) + " map");
+
+        ///start == fin scenarios stay in, every engine has to hand back just the start tile for those, at a cost of 0
+        queries.push_back({scen.start, scen.fin});
+
+        double best = reference_cost(*bench.tmap, scen.start, scen.fin);
+
+        if(best < 0 || best > scen.optimal_length + 1e-3 * std::max(scen.optimal_length, 1.))
+        {
+            over_expected++;
+            printf("  dijkstra: %i %i -> %i %i costs %f, expected %f\n", scen.start.x(), scen.start.y(), scen.fin.x(), scen.fin.y(), best, scen.optimal_length);
+        }
+        else if(best < scen.optimal_length - 1e-3)
+            cut_corners++;
+    }
+
+    int mismatches = run_map(bench, engines, queries);
+
+    printf("%i of %i scenarios shorter than expected by cutting corners\n", cut_corners, (int)queries.size());
+
+    return mismatches + over_expected;
+}
+
+int main(int argc, char* argv[])
+{
+    bool quick = argc > 1 && std::string(argv[1]) == "quick";
+
+    std::vector<engine> engines =
+    {
+        {"astar", path_mode::ASTAR, true},
+        {"jps", path_mode::JUMP_POINT, true},
+        {"hpa", path_mode::HIERARCHICAL, false},
+    };
+
+    printf("%-22s %-10s %8s %12s %12s %12s %10s %6s\n", "map", "engine", "queries", "nodes/query", "ns/query", "p99 ns", "worst/opt", "wrong");
+
+    if(argc > 3 && std::string(argv[1]) == "movingai")
+    {
+        int mismatches = run_movingai(engines, argv[2], argv[3]);
+
+        if(mismatches > 0)
+        {
+            printf("%i paths disagreed with dijkstra or the expected lengths\n", mismatches);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    std::vector<int> battle_sizes = {30, 128, 512, 2048};
+    std::vector<int> densities = {0, 10, 25, 40};
+    std::vector<int> overworld_sizes = {150, 512};
+
+    if(quick)
+        battle_sizes.pop_back();
+
+    int mismatches = 0;
+    uint32_t seed = 1;
+
+    ///big maps get fewer queries, each one costs a full dijkstra to check
+    auto queries_for = [](int size){return size <= 128 ? 500 : (size <= 512 ? 100 : 20);};
+
+    for(int size : battle_sizes)
+    {
+        for(int density : densities)
+        {
+            bench_map bench;
+            make_battle_map(bench, {size, size}, density, seed++);
+
+            mismatches += run_map(bench, engines, make_queries(*bench.tmap, queries_for(size), seed++));
+        }
+    }
+
+    for(int size : overworld_sizes)
+    {
+        bench_map bench;
+        make_overworld_map(bench, {size, size}, seed++);
+
+        mismatches += run_map(bench, engines, make_queries(*bench.tmap, queries_for(size), seed++));
+    }
+
+    ///a small hand made map in the MovingAI format, not one of the real benchmark sets, so it only checks that the importer and replay work
+    mismatches += run_movingai(engines, "bench/movingai/handmade_room16.map", "bench/movingai/handmade_room16.map.scen");
+
+    if(mismatches > 0)
+    {
+        printf("%i paths disagreed with dijkstra\n", mismatches);
+        return 1;
+    }
+
+    return 0;
+}
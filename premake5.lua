@@ -50,6 +50,40 @@ NetworkingSourceFiles["networking1"] = "include/networking/beast_compilation_uni
 NetworkingSourceFiles["networking2"] = "include/networking/networking.cpp"
 NetworkingSourceFiles["networking3"] = "include/networking/serialisable.cpp"
 
+-- Libraries every project links against under gmake2
+GmakeLinks =
+{
+    "mingw32",
+    "ssl",
+    "glfw3",
+    "glew32",
+    "sfml-audio",
+    "sfml-graphics",
+    "sfml-system",
+    "sfml-window",
+    "harfbuzz",
+    "freetype",
+    "harfbuzz",
+    "freetype",
+    "graphite2",
+    "opengl32",
+    "flac",
+    "png",
+    "z",
+    "bz2",
+    "rpcrt4",
+    "openal",
+    "ogg",
+    "ole32",
+    "dbgeng",
+    "crypto",
+    --"backtrace",
+    "gdi32",
+    "ws2_32",
+    "lmdb",
+    "winmm"
+}
+
 project "DwarfAndBlade"
     location "."
     kind "ConsoleApp"
@@ -115,38 +149,7 @@ project "DwarfAndBlade"
     }
 
     configuration {"gmake2"}
-        links
-        {
-            "mingw32",
-            "ssl",
-            "glfw3",
-            "glew32",
-            "sfml-audio",
-            "sfml-graphics",
-            "sfml-system",
-            "sfml-window",
-            "harfbuzz",
-            "freetype",
-            "harfbuzz",
-            "freetype",
-            "graphite2",
-            "opengl32",
-            "flac",
-            "png",
-            "z",
-            "bz2",
-            "rpcrt4",
-            "openal",
-            "ogg",
-            "ole32",
-            "dbgeng",
-            "crypto",
-            --"backtrace",
-            "gdi32",
-            "ws2_32",
-            "lmdb",
-            "winmm"
-        }
+        links(GmakeLinks)
 
     filter "system:windows"
         systemversion "latest"
@@ -191,4 +194,104 @@ project "DwarfAndBlade"
             buildoptions 
             {
                 "-std=c++17", "-Wall", "-Wextra", "-Wformat", "-g", "-Og"
-            }
\ No newline at end of file
+            }
+
+-- Headless pathfinding benchmark, builds the game sources without main.cpp
+-- Exits nonzero if any exact engine disagrees with the reference dijkstra
+project "PathBench"
+    location "."
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+    staticruntime "on"
+
+    targetdir ("builds/bin/" .. outputdir .. "/%{prj.name}")
+    objdir ("builds/bin-int/" .. outputdir .. "/%{prj.name}")
+
+    filter {"toolset:vs*"}
+        buildoptions {"/bigobj" , "/permissive-"}
+
+    filter{}
+
+    files
+    {
+        "bench/**.cpp",
+        "src/**.h",
+        "src/**.hpp",
+        "src/**.cpp",
+        "%{SourceFiles.ndb}",
+        "%{ImguiSourceFiles.imgui1}",
+        "%{ImguiSourceFiles.imgui2}",
+        "%{ImguiSourceFiles.imgui3}",
+        "%{ImguiSourceFiles.imgui4}",
+        "%{ImguiSourceFiles.imgui5}",
+        "%{ImguiSourceFiles.imgui6}",
+        "%{ToolkitSourceFiles.toolkit1}",
+        "%{ToolkitSourceFiles.toolkit2}",
+        "%{ToolkitSourceFiles.toolkit3}",
+        "%{ToolkitSourceFiles.toolkit4}",
+        "%{ToolkitSourceFiles.toolkit5}",
+        "%{ToolkitSourceFiles.toolkit6}",
+        "%{ToolkitSourceFiles.toolkit7}",
+        "%{ToolkitSourceFiles.toolkit8}",
+        "%{NetworkingSourceFiles.networking1}",
+        "%{NetworkingSourceFiles.networking2}",
+        "%{NetworkingSourceFiles.networking3}",
+    }
+
+    removefiles
+    {
+        "src/main.cpp"
+    }
+
+    defines{
+        "_CRT_SECURE_NO_WARNINGS"
+    }
+
+    includedirs
+    {
+        "./src",
+        "%{IncludeDir.include}",
+        "%{IncludeDir.ImGui}",
+        "%{IncludeDir.entt}",
+        "/mingw64/include/freetype2"
+    }
+
+    links
+    {
+        "opengl32",
+    }
+
+    configuration {"gmake2"}
+        links(GmakeLinks)
+
+    filter "system:windows"
+        systemversion "latest"
+
+        defines
+        {
+            "GLFW_INCLUDE_NONE",
+            "NO_OPENCL",
+            "NO_STACKTRACE",
+            "IMGUI_IMPL_OPENGL_LOADER_GLEW",
+            "__WIN32__",
+            "ImDrawIdx=unsigned int",
+            "SERIALISE_ENTT"
+        }
+
+    configuration "Debug"
+        defines {"ENGINE_DEBUG", "DEBUG"}
+        runtime "Debug"
+        symbols "on"
+
+    -- timings only mean anything with optimisations on
+    configuration "gmake2"
+        buildoptions
+        {
+            "-std=c++17", "-Wall", "-Wextra", "-Wformat", "-O2"
+        }
+
+    configuration "Release"
+        defines "ENGINE_RELEASE"
+        runtime "Release"
+        optimize "on"
@@ -35,7 +35,7 @@ entt::entity battle_map::create_battle(entt::registry& registry, random_state& r
                 registry.assign<battle_tag>(base, battle_tag());
                 //registry.assign<mouse_interactable>(base, mouse_interactable());
 
-                tmap.add(base, { x, y });
+                tmap.add(registry, base, { x, y });
             }
         }
     }
@@ -57,6 +57,9 @@ entt::entity battle_map::create_battle(entt::registry& registry, random_state& r
     registry.assign<tilemap>(res, tmap);
     registry.assign<battle_tag>(res, battle_tag());
     registry.assign<battle_map_state>(res, battle_map_state());
+    registry.assign<team_flow_fields>(res, team_flow_fields());
+    registry.assign<path_service>(res, path_service());
+    registry.assign<reservation_table>(res, reservation_table());
 
     return res;
 }
@@ -87,7 +90,7 @@ void battle_map::distribute_entities(entt::registry& registry, tilemap& tmap, ra
 
             auto base = create_scenery(registry, handle, trans, coll);
 
-            tmap.add(base, { x, y });
+            tmap.add(registry, base, { x, y });
         }
     }
 }
@@ -167,7 +170,7 @@ entt::entity create_obstacle_at(entt::registry& registry, random_state& rng, vec
 
     entt::entity obstacle = battle_map::create_obstacle(registry, handle, transform, path_cost);
 
-    map.add(obstacle, pos);
+    map.add(registry, obstacle, pos);
 }
 
 
@@ -176,15 +179,48 @@ void battle_map::battle_map_state::update_ai(entt::registry& registry, entt::ent
     auto view = registry.view<battle_tag, tilemap_position, render_descriptor, sprite_handle, wandering_ai> ();
 
     tilemap& tmap = registry.get<tilemap>(map);
+    team_flow_fields& flows = registry.get<team_flow_fields>(map);
+    path_service& paths = registry.get<path_service>(map);
+    reservation_table& reservations = registry.get<reservation_table>(map);
+
+    flows.begin_tick();
+    //anything planned since last tick is handed over here, never halfway through
+    paths.begin_tick(registry, tmap);
+
+    bool step_due = reservations.tick(delta_time);
+
+    std::vector<entt::entity> movers;
 
     for (auto ent : view)
     {
         auto& ai = view.get<wandering_ai>(ent);
         auto& desc = view.get<render_descriptor>(ent);
 
-        ai.tick_ai(registry, delta_time, tmap, ent, rng);
+        //cooperative units all step together so their reservations line up
+        if (reservations.enabled)
+        {
+            if (step_due)
+            {
+                ai.move_ai(registry, tmap, flows, paths, reservations, ent, rng);
+
+                if (ai.queued_step.has_value())
+                    movers.push_back(ent);
+            }
+        }
+        else
+        {
+            ai.tick_ai(registry, delta_time, tmap, flows, paths, reservations, ent, rng);
+        }
+
         ai.tick_animation(delta_time, desc);
     }
+
+    //everyone's decided where they're going, so nobody's held up by who happened to go first
+    if (step_due)
+    {
+        apply_cooperative_steps(registry, tmap, movers);
+        reservations.end_step();
+    }
 }
 
 void battle_map::battle_map_state::battle_editor(entt::registry& registry, entt::entity& map, random_state& rng, render_window& win, camera& cam, vec2f mpos)
@@ -229,7 +265,7 @@ void battle_map::battle_map_state::battle_editor(entt::registry& registry, entt:
             coll.cost = 150;
             registry.assign<collidable>(enemy_unit, coll);
 
-            tmap.add(enemy_unit, start_pos);
+            tmap.add(registry, enemy_unit, start_pos);
         }
 
         if (state.current_item == combobox_items::PLAYER_UNITS)
@@ -250,7 +286,7 @@ void battle_map::battle_map_state::battle_editor(entt::registry& registry, entt:
             coll.cost = 150;
             registry.assign<collidable>(player_unit, coll);
 
-            tmap.add(player_unit, start_pos);
+            tmap.add(registry, player_unit, start_pos);
         }
     }
 
@@ -273,6 +309,10 @@ void battle_map::battle_map_state::battle_editor(entt::registry& registry, entt:
         }
         ImGui::EndCombo();
     }
+
+    reservation_table& reservations = registry.get<reservation_table>(map);
+    ImGui::Checkbox("Cooperative pathing", &reservations.enabled);
+
     ImGui::End();
 }
 
@@ -320,7 +360,7 @@ void battle_map::battle_map_state::unit_editor(entt::registry& registry, entt::e
         std::string button_label = "Destroy unit!##" + std::to_string(id);
         if (ImGui::Button(button_label.c_str()))
         {
-            tmap.remove(ent, tmap_pos.pos);
+            tmap.remove(registry, ent, tmap_pos.pos);
             health.damage_amount(health.max_hp);
         };
         id += 1;
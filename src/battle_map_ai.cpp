@@ -1,5 +1,9 @@
 #include "battle_map_ai.hpp"
 
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
 #include "camera.hpp"
 #include "battle_map.hpp"
 
@@ -8,6 +12,9 @@ void wandering_ai::tick_ai
     entt::registry&     registry,
     float               delta_time,
     tilemap&            tmap,
+    team_flow_fields&   flows,
+    path_service&       paths,
+    reservation_table&  reservations,
     entt::entity        en,
     random_state&       rng
 )
@@ -19,13 +26,16 @@ void wandering_ai::tick_ai
 
     time_left_before_move_tiles = time_between_move_tiles;
 
-    move_ai(registry, tmap, en, rng);
+    move_ai(registry, tmap, flows, paths, reservations, en, rng);
 }
 
 void wandering_ai::move_ai
 (
     entt::registry&     registry,
     tilemap&            tmap,
+    team_flow_fields&   flows,
+    path_service&       paths,
+    reservation_table&  reservations,
     entt::entity        en,
     random_state&       rng
 )
@@ -35,10 +45,17 @@ void wandering_ai::move_ai
     damageable& my_health = registry.get<damageable>(en);
     battle_map::battle_unit_info& my_info = registry.get<battle_map::battle_unit_info>(en);
 
-    if (my_health.cur_hp <= 0) 
+    if (my_health.cur_hp <= 0)
+    {
+        if (path_ticket.has_value())
+            paths.cancel(path_ticket.value());
+
+        path_ticket = std::nullopt;
+        reservations.release(en);
         return;
+    }
 
-    std::optional<entt::entity> nearest = closest_alive_enemy_entity(registry, en);
+    std::optional<entt::entity> nearest = closest_alive_enemy_entity(registry, tmap, en);
 
     if (!nearest.has_value())
         return;
@@ -75,26 +92,407 @@ void wandering_ai::move_ai
         }
     }
 
-    std::optional<std::vector<vec2i>> path = a_star(registry, tmap, my_pos.pos, destination_xy);
+    if (path_ticket.has_value())
+        collect_path(registry, paths, en);
+
+    path_staleness::type staleness = path_ticket.has_value() ? path_staleness::FRESH : check_path(registry, tmap, en);
+
+    //someone moved across our path, which is a small local repair rather than a whole new search
+    if (staleness == path_staleness::COSTS_CHANGED)
+        repair_path(registry, tmap, en);
+
+    if (staleness == path_staleness::RETARGET)
+        request_path(registry, paths, en, nearest.value());
+
+    if (reservations.enabled)
+    {
+        cooperative_step(registry, tmap, flows, reservations, en);
+        return;
+    }
+
+    //with nothing to walk yet, the shared team field gets us going straight away while the path service works on a real path
+    if (path.size() == 0)
+    {
+        vec2i next_p = follow_field(registry, tmap, flows, en, 1);
+
+        if (next_p != my_pos.pos && tmap.path_cost[next_p.y() * tmap.dim.x() + next_p.x()] != -1)
+            finish_step(registry, tmap, en, next_p);
+
+        return;
+    }
+
+    //the last tile is the enemy, dont walk into it
+    if (path_next + 1 >= (int)path.size())
+        return;
+
+    vec2i next_p = clamp(path[path_next], vec2i{ 0, 0 }, tmap.dim - 1);
+
+    //keep walking the old path while we wait for a new one, but not through anything that's appeared on it
+    if (tmap.path_cost[next_p.y() * tmap.dim.x() + next_p.x()] == -1)
+        return;
+
+    path_next++;
+
+    //update renderer
+    my_desc.pos = camera::tile_to_world(vec2f{ next_p.x(), next_p.y() });
+    //update map
+    tmap.move(registry, en, my_pos.pos, next_p);
+    //update position
+    my_pos.pos = next_p;
+}
+
+path_staleness::type wandering_ai::check_path
+(
+    entt::registry&     registry,
+    tilemap&            tmap,
+    entt::entity        en
+)
+{
+    if (path.size() == 0 || !path_target.has_value())
+        return path_staleness::RETARGET;
+
+    //something else moved us
+    if (path[path_next - 1] != registry.get<tilemap_position>(en).pos)
+        return path_staleness::RETARGET;
+
+    entt::entity target = path_target.value();
+
+    if (!registry.valid(target) || registry.get<damageable>(target).cur_hp <= 0)
+        return path_staleness::RETARGET;
+
+    vec2i target_pos = registry.get<tilemap_position>(target).pos;
+    vec2i drift = target_pos - path.back();
+    int distance = std::max(abs(drift.x()), abs(drift.y()));
+
+    if (distance > retarget_tolerance)
+        return path_staleness::RETARGET;
+
+    //we've walked the whole thing and they're not where we left them
+    if (path_next + 1 >= (int)path.size() && distance > 0)
+        return path_staleness::RETARGET;
+
+    if (tmap.cost_revision() == path_revision)
+        return path_staleness::FRESH;
+
+    //only cells that have changed since we planned matter
+    for (auto it = path.iterator_at(path_next); it.index < path.size() - 1; ++it)
+    {
+        int idx = (*it).y() * tmap.dim.x() + (*it).x();
+
+        if (tmap.cost_changed_at[idx] > path_revision)
+            return path_staleness::COSTS_CHANGED;
+    }
+
+    return path_staleness::FRESH;
+}
+
+void wandering_ai::repair_path
+(
+    entt::registry&     registry,
+    tilemap&            tmap,
+    entt::entity        en
+)
+{
+    vec2i my_pos = registry.get<tilemap_position>(en).pos;
+    vec2i goal = path.back();
+
+    std::vector<vec2i> repaired;
+
+    //the first repair towards a goal is a full search, every one after that only touches what changed
+    if (planner.tracking(goal))
+    {
+        repaired = planner.replan(tmap, my_pos);
+        repairs_since_reseed++;
+    }
+    else if (planner.nodes.size() == 0 || repairs_since_reseed >= min_repairs_per_reseed)
+    {
+        planner.reset(tmap, my_pos, goal);
+        repaired = planner.replan(tmap, my_pos);
+        repairs_since_reseed = 0;
+    }
+    else
+    {
+        //the goal's moving too often to be worth seeding, so a one off search on the map's shared scratch, leaving the planner where it was
+        //out in the open that's a jump point search, which skips straight over the empty ground
+        tmap.jump_points.update(tmap);
+
+        if (tmap.jump_points.mostly_uniform())
+            repaired = get_jump_point_path(tmap, my_pos, goal, -1);
+        else
+            repaired = get_shortest_path(tmap.path_cost.data(), tmap.dim, tmap.search, my_pos, goal);
+
+        repairs_since_reseed++;
+    }
+
+    //walled off for now, go find someone else
+    if (repaired.size() == 0)
+    {
+        path_target = std::nullopt;
+        return;
+    }
+
+    path = std::move(repaired);
+    path_next = 1;
+    path_revision = tmap.cost_revision();
+    destination_xy = path.back();
+}
+
+vec2i wandering_ai::follow_field
+(
+    entt::registry&     registry,
+    tilemap&            tmap,
+    team_flow_fields&   flows,
+    entt::entity        en,
+    int                 steps
+)
+{
+    vec2i pos = registry.get<tilemap_position>(en).pos;
+
+    //every unit on a team shares one field
+    const flow_field& field = flows.get(registry, tmap, registry.get<team>(en).t);
+
+    for (int i = 0; i < steps; i++)
+    {
+        std::optional<vec2i> next = field.next_step(pos);
+
+        //the field ends on the enemy, dont walk into it
+        if (!next.has_value() || field.distance_at(next.value()) == 0)
+            break;
+
+        pos = next.value();
+    }
+
+    return pos;
+}
+
+void wandering_ai::cooperative_step
+(
+    entt::registry&     registry,
+    tilemap&            tmap,
+    team_flow_fields&   flows,
+    reservation_table&  reservations,
+    entt::entity        en
+)
+{
+    tilemap_position& my_pos = registry.get<tilemap_position>(en);
+
+    uint64_t now = reservations.now;
+    int step = (int)(now - window_start);
+
+    //replan halfway through the window so there's always something reserved ahead, or sooner if we've been held up
+    bool replan_window = window.size() == 0 || now < window_start || step >= reservations.window / 2 ||
+                         step + 1 >= (int)window.size() || window[step] != my_pos.pos;
+
+    if (replan_window)
+    {
+        //head for a tile about a window along our path, but never onto the enemy at the end of it
+        vec2i waypoint = my_pos.pos;
+
+        if (path_next + 1 < (int)path.size())
+            waypoint = path[std::min(path_next + reservations.window - 1, (int)path.size() - 2)];
+        else if (path.size() == 0)
+            waypoint = follow_field(registry, tmap, flows, en, reservations.window - 1);
+
+        reservations.release(en);
+        window = reservations.plan(tmap, en, my_pos.pos, waypoint);
+        window_start = now;
+        step = 0;
+    }
+
+    if (step + 1 >= (int)window.size())
+        return;
+
+    vec2i next_p = window[step + 1];
+
+    if (next_p == my_pos.pos)
+        return;
+
+    //whether whoever's there now gets out of the way in time depends on everyone else's step, so that's sorted out once the whole batch has decided
+    queued_step = next_p;
+}
+
+void wandering_ai::finish_step
+(
+    entt::registry&     registry,
+    tilemap&            tmap,
+    entt::entity        en,
+    vec2i               next_p
+)
+{
+    tilemap_position& my_pos = registry.get<tilemap_position>(en);
+    render_descriptor& my_desc = registry.get<render_descriptor>(en);
+
+    //update renderer
+    my_desc.pos = camera::tile_to_world(vec2f{ next_p.x(), next_p.y() });
+    //update map
+    tmap.move(registry, en, my_pos.pos, next_p);
+    //update position
+    my_pos.pos = next_p;
+
+    //stepping aside takes us off our path, so patch it up from here
+    if (path_next < (int)path.size() && path[path_next] == next_p)
+        path_next++;
+    else if (path.size() > 0)
+        repair_path(registry, tmap, en);
+}
+
+namespace step_state
+{
+    enum type
+    {
+        UNKNOWN,
+        RESOLVING,
+        MOVES,
+        WAITS,
+    };
+}
+
+void apply_cooperative_steps(entt::registry& registry, tilemap& tmap, const std::vector<entt::entity>& movers)
+{
+    std::vector<int> targets;
+    //who's stepping out of each tile
+    std::unordered_map<int, int> leaving;
+
+    for (int i = 0; i < (int)movers.size(); i++)
+    {
+        vec2i pos = registry.get<tilemap_position>(movers[i]).pos;
+        vec2i next_p = registry.get<wandering_ai>(movers[i]).queued_step.value();
+
+        leaving[pos.y() * tmap.dim.x() + pos.x()] = i;
+        targets.push_back(next_p.y() * tmap.dim.x() + next_p.x());
+    }
 
-    if (path.has_value())
+    std::vector<step_state::type> state(movers.size(), step_state::UNKNOWN);
+
+    //the reservations keep this from happening, but anyone who's ended up off their window mustn't double up, so only the first one in gets to go
+    std::unordered_set<int> wanted;
+
+    for (int i = 0; i < (int)movers.size(); i++)
     {
-        std::vector<vec2i> points = path.value();
+        if (!wanted.insert(targets[i]).second)
+            state[i] = step_state::WAITS;
+    }
 
-        //next step
-        points.erase(points.begin());
-        vec2i next_p = points.front();
-        next_p = clamp(next_p, vec2i{ 0, 0 }, tmap.dim - 1);
+    //follows the chain of whoever's in the way until it gets to an empty tile, someone who's staying put, or back round to the start
+    auto resolve = [&](int first)
+    {
+        std::vector<int> chain;
+        int current = first;
+        step_state::type result = step_state::WAITS;
 
-        //update renderer
-        my_desc.pos = camera::tile_to_world(vec2f{ next_p.x(), next_p.y() });
-        //update map
-        tmap.move(en, my_pos.pos, next_p);
-        //update position
-        my_pos.pos = next_p;
+        while (true)
+        {
+            if (state[current] == step_state::MOVES || state[current] == step_state::WAITS)
+            {
+                result = state[current];
+                break;
+            }
+
+            //every tile's only wanted by one unit, so this can only be a ring, and everyone in it shuffles round at once
+            if (state[current] == step_state::RESOLVING)
+            {
+                result = step_state::MOVES;
+                break;
+            }
+
+            state[current] = step_state::RESOLVING;
+            chain.push_back(current);
+
+            int next_cell = targets[current];
+
+            if (tmap.dynamic_occupancy[next_cell] == 0)
+            {
+                result = step_state::MOVES;
+                break;
+            }
+
+            auto it = leaving.find(next_cell);
+
+            //someone who isn't playing along, or a corpse, or more than one thing is there. Wait for them to move
+            if (it == leaving.end() || tmap.dynamic_occupancy[next_cell] > 1)
+            {
+                result = step_state::WAITS;
+                break;
+            }
+
+            current = it->second;
+        }
+
+        for (int idx : chain)
+        {
+            state[idx] = result;
+        }
+    };
+
+    for (int i = 0; i < (int)movers.size(); i++)
+    {
+        if (state[i] == step_state::UNKNOWN)
+            resolve(i);
+    }
+
+    //everyone's been checked against where everyone started, so the order they actually move in doesn't matter
+    for (int i = 0; i < (int)movers.size(); i++)
+    {
+        wandering_ai& ai = registry.get<wandering_ai>(movers[i]);
+
+        vec2i next_p = ai.queued_step.value();
+        ai.queued_step = std::nullopt;
+
+        if (state[i] == step_state::MOVES)
+            ai.finish_step(registry, tmap, movers[i], next_p);
     }
 }
 
+void wandering_ai::request_path
+(
+    entt::registry&     registry,
+    path_service&       paths,
+    entt::entity        en,
+    entt::entity        target
+)
+{
+    vec2i my_pos = registry.get<tilemap_position>(en).pos;
+    vec2i target_pos = registry.get<tilemap_position>(target).pos;
+
+    //whoever's closest to a fight gets their path first
+    vec2i diff = target_pos - my_pos;
+    int priority = -std::max(abs(diff.x()), abs(diff.y()));
+
+    path_ticket = paths.submit(my_pos, target_pos, path_cost_policy::ALL, priority, en);
+    pending_target = target;
+}
+
+void wandering_ai::collect_path
+(
+    entt::registry&     registry,
+    path_service&       paths,
+    entt::entity        en
+)
+{
+    std::optional<path_result> res = paths.take(path_ticket.value());
+
+    if (!res.has_value())
+        return;
+
+    path_ticket = std::nullopt;
+
+    std::vector<vec2i>& found = res.value().path;
+    vec2i my_pos = registry.get<tilemap_position>(en).pos;
+
+    //we kept moving while it was planned, so pick it up from wherever we are now
+    auto it = std::find(found.begin(), found.end(), my_pos);
+
+    //no way there, or we've wandered off it. Either way the old path stays stale and we ask again
+    if (it == found.end())
+        return;
+
+    path_next = (int)(it - found.begin()) + 1;
+    path = std::move(found);
+    path_revision = res.value().revision;
+    path_target = pending_target;
+    destination_xy = path.back();
+}
+
 void wandering_ai::tick_animation
 (
     float delta_time,
@@ -199,7 +597,7 @@ std::optional<entt::entity> closest_alive_entity(entt::registry& registry, entt:
     return closest_entity;
 }
 
-std::optional<entt::entity> closest_alive_enemy_entity(entt::registry & registry, entt::entity en)
+std::optional<entt::entity> closest_alive_enemy_entity(entt::registry & registry, tilemap& tmap, entt::entity en)
 {
     tilemap_position& my_pos = registry.get<tilemap_position>(en);
     team& my_team = registry.get<team>(en);
@@ -227,6 +625,10 @@ std::optional<entt::entity> closest_alive_enemy_entity(entt::registry & registry
 
         tilemap_position other_ai_pos = view.get<tilemap_position>(ent);
 
+        //dont pick fights with anyone we can't get to
+        if (!tmap.can_reach(my_pos.pos, other_ai_pos.pos))
+            continue;
+
         int distance_from_current_squared = abs(my_pos.pos.squared_length() - other_ai_pos.pos.squared_length());
 
         if (distance_from_current_squared < max_dist)
@@ -4,10 +4,27 @@
 #include "tilemap.hpp"
 #include "random.hpp"
 #include "pathfinding.hpp"
+#include "flow_field.hpp"
+#include "path_service.hpp"
+#include "incremental_path.hpp"
+#include "cooperative_path.hpp"
+#include "compact_path.hpp"
 #include "entity_common.hpp"
 
 std::optional<entt::entity> closest_alive_entity(entt::registry& registry, entt::entity en);
-std::optional<entt::entity> closest_alive_enemy_entity(entt::registry& registry, entt::entity en);
+std::optional<entt::entity> closest_alive_enemy_entity(entt::registry& registry, tilemap& tmap, entt::entity en);
+
+namespace path_staleness
+{
+    enum type
+    {
+        FRESH,
+        ///something on the rest of the path got cheaper or dearer, the goal is still good
+        COSTS_CHANGED,
+        ///the target's gone or wandered off, or we have no path at all
+        RETARGET,
+    };
+}
 
 struct wandering_ai
 {
@@ -16,6 +33,29 @@ struct wandering_ai
     float time_between_move_tiles = 1.;
     float time_left_before_move_tiles = time_between_move_tiles;
 
+    ///the path we're walking, kept between moves. path[path_next] is the next tile to step to, path.back() is the enemy we're after
+    compact_path path;
+    int path_next = 0;
+    ///tmap.cost_revision() when the path was planned
+    uint64_t path_revision = 0;
+    std::optional<entt::entity> path_target;
+    ///how far the target can wander from the end of the path before we bother replanning
+    int retarget_tolerance = 2;
+    ///replans go through the path service, and we keep walking the old path until the result comes back
+    std::optional<uint64_t> path_ticket;
+    std::optional<entt::entity> pending_target;
+    ///repairs the path in place when other units move across it
+    incremental_path planner;
+    ///repairs since the planner was last pointed at a new goal. A target that keeps changing would otherwise have us paying for a fresh search
+    ///and throwing it away every time, so until this reaches min_repairs_per_reseed new goals get a one off search instead
+    int repairs_since_reseed = 0;
+    int min_repairs_per_reseed = 4;
+    ///where we've reserved to stand, window[i] being at reservations.now == window_start + i
+    std::vector<vec2i> window;
+    uint64_t window_start = 0;
+    ///where we're stepping to this batch. Nobody moves until everyone's decided, see apply_cooperative_steps
+    std::optional<vec2i> queued_step;
+
     //animation
     float time_between_animation_updates = 0.25f;
     float time_left_before_animation_update = time_between_animation_updates;
@@ -28,6 +68,9 @@ struct wandering_ai
         entt::registry&     registry, 
         float               delta_time, 
         tilemap&            tmap, 
+        team_flow_fields&   flows,
+        path_service&       paths,
+        reservation_table&  reservations,
         entt::entity        en,
         random_state&       rng
     );
@@ -36,10 +79,69 @@ struct wandering_ai
     (
         entt::registry&     registry,
         tilemap&            tmap,
+        team_flow_fields&   flows,
+        path_service&       paths,
+        reservation_table&  reservations,
         entt::entity        en,
         random_state&       rng
     );
 
+    path_staleness::type check_path
+    (
+        entt::registry&     registry,
+        tilemap&            tmap,
+        entt::entity        en
+    );
+
+    void repair_path
+    (
+        entt::registry&     registry,
+        tilemap&            tmap,
+        entt::entity        en
+    );
+
+    ///up to steps tiles along the team field from where we're stood, stopping short of the enemy it flows into
+    vec2i follow_field
+    (
+        entt::registry&     registry,
+        tilemap&            tmap,
+        team_flow_fields&   flows,
+        entt::entity        en,
+        int                 steps
+    );
+
+    void cooperative_step
+    (
+        entt::registry&     registry,
+        tilemap&            tmap,
+        team_flow_fields&   flows,
+        reservation_table&  reservations,
+        entt::entity        en
+    );
+
+    void finish_step
+    (
+        entt::registry&     registry,
+        tilemap&            tmap,
+        entt::entity        en,
+        vec2i               next_p
+    );
+
+    void request_path
+    (
+        entt::registry&     registry,
+        path_service&       paths,
+        entt::entity        en,
+        entt::entity        target
+    );
+
+    void collect_path
+    (
+        entt::registry&     registry,
+        path_service&       paths,
+        entt::entity        en
+    );
+
     void tick_animation
     (
         float               delta_time,
@@ -55,3 +157,6 @@ struct wandering_ai
     void show_path_colours_on_tilemap(tilemap& tmap, entt::registry& registry, std::vector<vec2i> points, vec2i destination);
 };
 
+///moves everyone who queued a step this batch, in one go
+///a unit only steps into a tile once whoever's standing there is stepping out, however far down the line that goes, and rings of units each following the next all step together
+void apply_cooperative_steps(entt::registry& registry, tilemap& tmap, const std::vector<entt::entity>& movers);
@@ -0,0 +1,296 @@
+#include "compact_path.hpp"
+
+#include <stdexcept>
+
+int path_block_pool::allocate()
+{
+    if(free_head == -1)
+    {
+        blocks.emplace_back();
+        return blocks.size() - 1;
+    }
+
+    int ret = free_head;
+
+    free_head = blocks[ret].next;
+    blocks[ret].next = -1;
+
+    return ret;
+}
+
+void path_block_pool::release_chain(int first)
+{
+    while(first != -1)
+    {
+        int next = blocks[first].next;
+
+        blocks[first].next = free_head;
+        free_head = first;
+
+        first = next;
+    }
+}
+
+path_block_pool& get_thread_local_path_pool()
+{
+    static thread_local path_block_pool pool;
+
+    return pool;
+}
+
+static int direction_code(vec2i diff)
+{
+    for(int i = 0; i < 8; i++)
+    {
+        if(compact_path::directions[i] == diff)
+            return i;
+    }
+
+    return -1;
+}
+
+compact_path::compact_path(const std::vector<vec2i>& tiles)
+{
+    assign(tiles);
+}
+
+compact_path::compact_path(const compact_path& other)
+{
+    *this = other;
+}
+
+compact_path::compact_path(compact_path&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+compact_path& compact_path::operator=(const compact_path& other)
+{
+    if(this == &other)
+        return *this;
+
+    clear();
+
+    first = other.first;
+    last = other.last;
+    length = other.length;
+
+    path_block_pool& pool = get_thread_local_path_pool();
+
+    int tail = -1;
+
+    for(int from = other.head_block; from != -1; from = pool.blocks[from].next)
+    {
+        ///allocating can move the blocks about, so no holding references across it
+        int to = pool.allocate();
+
+        pool.blocks[to] = pool.blocks[from];
+        pool.blocks[to].next = -1;
+
+        if(tail == -1)
+            head_block = to;
+        else
+            pool.blocks[tail].next = to;
+
+        tail = to;
+    }
+
+    return *this;
+}
+
+compact_path& compact_path::operator=(compact_path&& other) noexcept
+{
+    if(this == &other)
+        return *this;
+
+    clear();
+
+    first = other.first;
+    last = other.last;
+    length = other.length;
+    head_block = other.head_block;
+
+    other.length = 0;
+    other.head_block = -1;
+
+    return *this;
+}
+
+compact_path::~compact_path()
+{
+    clear();
+}
+
+void compact_path::clear()
+{
+    if(head_block != -1)
+        get_thread_local_path_pool().release_chain(head_block);
+
+    head_block = -1;
+    length = 0;
+}
+
+void compact_path::assign(const std::vector<vec2i>& tiles)
+{
+    clear();
+
+    if(tiles.size() == 0)
+        return;
+
+    path_block_pool& pool = get_thread_local_path_pool();
+
+    first = tiles.front();
+    last = tiles.back();
+    length = tiles.size();
+
+    int tail = -1;
+
+    for(int step = 0; step < length - 1; step++)
+    {
+        int slot = step % path_block_pool::steps_per_block;
+
+        if(slot == 0)
+        {
+            int next = pool.allocate();
+
+            pool.blocks[next].origin = tiles[step];
+
+            for(uint64_t& word : pool.blocks[next].words)
+            {
+                word = 0;
+            }
+
+            if(tail == -1)
+                head_block = next;
+            else
+                pool.blocks[tail].next = next;
+
+            tail = next;
+        }
+
+        int code = direction_code(tiles[step + 1] - tiles[step]);
+
+        if(code == -1)
+            throw std::runtime_error("Path tiles not adjacent");
+
+        pool.blocks[tail].words[slot / 21] |= (uint64_t)code << ((slot % 21) * 3);
+    }
+}
+
+int compact_path::code_at(int block, int step) const
+{
+    const path_block_pool::block& b = get_thread_local_path_pool().blocks[block];
+
+    return (b.words[step / 21] >> ((step % 21) * 3)) & 7;
+}
+
+compact_path::iterator compact_path::iterator_at(int index) const
+{
+    iterator it;
+    it.owner = this;
+    it.index = index;
+
+    if(index >= length)
+    {
+        it.index = length;
+        return it;
+    }
+
+    if(index == 0)
+    {
+        it.block = head_block;
+        it.pos = first;
+        return it;
+    }
+
+    const path_block_pool& pool = get_thread_local_path_pool();
+
+    int block = head_block;
+
+    for(int skip = index / path_block_pool::steps_per_block; skip > 0 && block != -1; skip--)
+    {
+        ///a path that ends exactly on a block boundary has no block for its last tile
+        if(pool.blocks[block].next == -1)
+            break;
+
+        block = pool.blocks[block].next;
+    }
+
+    int block_start = (index / path_block_pool::steps_per_block) * path_block_pool::steps_per_block;
+
+    if(index == length - 1)
+    {
+        it.block = block;
+        it.pos = last;
+        return it;
+    }
+
+    vec2i pos = pool.blocks[block].origin;
+
+    for(int step = 0; step < index - block_start; step++)
+    {
+        pos += directions[code_at(block, step)];
+    }
+
+    it.block = block;
+    it.pos = pos;
+
+    return it;
+}
+
+compact_path::iterator compact_path::end() const
+{
+    iterator it;
+    it.owner = this;
+    it.index = length;
+
+    return it;
+}
+
+compact_path::iterator& compact_path::iterator::operator++()
+{
+    if(index + 1 >= owner->length)
+    {
+        index = owner->length;
+        return *this;
+    }
+
+    int slot = index % path_block_pool::steps_per_block;
+
+    pos += directions[owner->code_at(block, slot)];
+    index++;
+
+    if(index % path_block_pool::steps_per_block == 0)
+        block = get_thread_local_path_pool().blocks[block].next;
+
+    return *this;
+}
+
+vec2i compact_path::operator[](int index) const
+{
+    return *iterator_at(index);
+}
+
+int compact_path::find(vec2i pos, int from) const
+{
+    for(iterator it = iterator_at(from); it != end(); ++it)
+    {
+        if(*it == pos)
+            return it.index;
+    }
+
+    return -1;
+}
+
+std::vector<vec2i> compact_path::decode() const
+{
+    std::vector<vec2i> ret;
+    ret.reserve(length);
+
+    for(vec2i pos : *this)
+    {
+        ret.push_back(pos);
+    }
+
+    return ret;
+}
@@ -0,0 +1,93 @@
+#ifndef COMPACT_PATH_HPP_INCLUDED
+#define COMPACT_PATH_HPP_INCLUDED
+
+#include <vector>
+#include <stdint.h>
+#include <vec/vec.hpp>
+
+///fixed size blocks of packed path steps, recycled through a free list so holding a path allocates nothing once it's warmed up
+struct path_block_pool
+{
+    static constexpr int words_per_block = 6;
+    ///3 bits a step, 21 to a word
+    static constexpr int steps_per_block = words_per_block * 21;
+
+    ///one cache line, a bit over 4 bits a step all in against 64 for a vec2i
+    struct block
+    {
+        ///the tile this block's first step leaves from, so you can jump into the middle of a path
+        vec2i origin;
+        uint64_t words[words_per_block];
+        int next = -1;
+    };
+
+    std::vector<block> blocks;
+    int free_head = -1;
+
+    int allocate();
+    void release_chain(int first);
+};
+
+///paths live on whichever thread made them, same as the registry
+path_block_pool& get_thread_local_path_pool();
+
+///a path of neighbouring tiles stored as a start tile plus a 3 bit direction per step. Reads like a container of vec2i
+///works for any unit on any tilemap, the steps don't know or care which map they're on
+struct compact_path
+{
+    ///same order as the pathfinding neighbour lists
+    static inline const vec2i directions[8] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+
+    vec2i first = {0, 0};
+    vec2i last = {0, 0};
+    ///in tiles, including the first
+    int length = 0;
+    int head_block = -1;
+
+    struct iterator
+    {
+        const compact_path* owner = nullptr;
+        int block = -1;
+        int index = 0;
+        vec2i pos = {0, 0};
+
+        vec2i operator*() const {return pos;}
+        iterator& operator++();
+
+        bool operator==(const iterator& other) const {return index == other.index;}
+        bool operator!=(const iterator& other) const {return index != other.index;}
+    };
+
+    compact_path() = default;
+    compact_path(const std::vector<vec2i>& tiles);
+    compact_path(const compact_path& other);
+    compact_path(compact_path&& other) noexcept;
+    compact_path& operator=(const compact_path& other);
+    compact_path& operator=(compact_path&& other) noexcept;
+    ~compact_path();
+
+    ///every tile has to be next to the one before it
+    void assign(const std::vector<vec2i>& tiles);
+    void clear();
+
+    int size() const {return length;}
+    bool empty() const {return length == 0;}
+    vec2i front() const {return first;}
+    vec2i back() const {return last;}
+
+    ///skips straight to the right block, then walks at most one block's worth of steps
+    vec2i operator[](int index) const;
+    iterator iterator_at(int index) const;
+
+    iterator begin() const {return iterator_at(0);}
+    iterator end() const;
+
+    ///index of pos at or after from, -1 if it's not on the path
+    int find(vec2i pos, int from = 0) const;
+    std::vector<vec2i> decode() const;
+
+private:
+    int code_at(int block, int step) const;
+};
+
+#endif // COMPACT_PATH_HPP_INCLUDED
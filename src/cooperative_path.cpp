@@ -0,0 +1,219 @@
+#include "cooperative_path.hpp"
+
+#include <algorithm>
+#include <queue>
+#include "tilemap.hpp"
+
+static uint64_t slot_key(int cell, uint64_t t)
+{
+    return (t << 32) | (uint32_t)cell;
+}
+
+bool reservation_table::tick(float delta_time)
+{
+    time_left_before_step -= delta_time;
+
+    if(time_left_before_step > 0.)
+        return false;
+
+    time_left_before_step = time_between_steps;
+
+    return true;
+}
+
+void reservation_table::end_step()
+{
+    now++;
+
+    ///nobody needs to know where anyone was
+    for(auto& [en, keys] : owned)
+    {
+        auto expired = std::remove_if(keys.begin(), keys.end(), [&](uint64_t key)
+        {
+            if((key >> 32) >= now)
+                return false;
+
+            slots.erase(key);
+            return true;
+        });
+
+        keys.erase(expired, keys.end());
+    }
+}
+
+std::optional<entt::entity> reservation_table::owner(int cell, uint64_t t) const
+{
+    auto it = slots.find(slot_key(cell, t));
+
+    if(it == slots.end())
+        return std::nullopt;
+
+    return it->second;
+}
+
+bool reservation_table::is_free(int cell, uint64_t t, entt::entity en) const
+{
+    std::optional<entt::entity> who = owner(cell, t);
+
+    return !who.has_value() || who.value() == en;
+}
+
+void reservation_table::reserve(int cell, uint64_t t, entt::entity en)
+{
+    uint64_t key = slot_key(cell, t);
+
+    slots[key] = en;
+    owned[en].push_back(key);
+}
+
+void reservation_table::release(entt::entity en)
+{
+    auto it = owned.find(en);
+
+    if(it == owned.end())
+        return;
+
+    for(uint64_t key : it->second)
+    {
+        auto slot = slots.find(key);
+
+        if(slot != slots.end() && slot->second == en)
+            slots.erase(slot);
+    }
+
+    owned.erase(it);
+}
+
+std::vector<vec2i> reservation_table::plan(const tilemap& tmap, entt::entity en, vec2i start, vec2i waypoint)
+{
+    ///same order as get_shortest_path, with waiting in place on the end
+    static const vec2i moves[9] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {1, -1}, {1, 1}, {-1, 1}, {0, 0}};
+
+    int size = tmap.dim.x() * tmap.dim.y();
+    int width = tmap.dim.x();
+
+    ///a state is a tile at a number of steps from now
+    auto state_of = [&](int cell, int depth){return depth * size + cell;};
+
+    std::unordered_map<int, float> g_score;
+    std::unordered_map<int, int> came_from;
+
+    using entry = std::pair<float, int>;
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry>> open;
+
+    auto h = [&](vec2i pos){return (pos - waypoint).length();};
+
+    int start_cell = start.y() * width + start.x();
+    int start_state = state_of(start_cell, 0);
+
+    g_score[start_state] = 0;
+    came_from[start_state] = -1;
+    open.push({h(start), start_state});
+
+    int found = -1;
+
+    while(!open.empty())
+    {
+        auto [f, current] = open.top();
+        open.pop();
+
+        int depth = current / size;
+        int cell = current % size;
+        float current_g = g_score[current];
+
+        ///already got here cheaper
+        if(f > current_g + h({cell % width, cell / width}) + 0.0001f)
+            continue;
+
+        ///past the window we don't care who's where, so the first state to get there is the best one
+        if(depth == window)
+        {
+            found = current;
+            break;
+        }
+
+        vec2i pos = {cell % width, cell / width};
+
+        for(const vec2i& move : moves)
+        {
+            vec2i next = pos + move;
+
+            if(next.x() < 0 || next.y() < 0 || next.x() >= tmap.dim.x() || next.y() >= tmap.dim.y())
+                continue;
+
+            int next_cell = next.y() * width + next.x();
+
+            ///other units are handled by the reservations, so only the scenery counts here
+            int cost = tmap.static_cost[next_cell];
+
+            if(cost == -1)
+                continue;
+
+            ///unless whoever's standing there isn't in the reservations, like a corpse or a unit that isn't cooperating, in which case they aren't going anywhere
+            if(next_cell != start_cell && tmap.dynamic_occupancy[next_cell] > 0 && !owner(next_cell, now).has_value())
+                continue;
+
+            uint64_t t = now + depth;
+
+            if(!is_free(next_cell, t + 1, en))
+                continue;
+
+            ///two units can't swap places through each other either
+            std::optional<entt::entity> coming = owner(next_cell, t);
+
+            if(coming.has_value() && coming.value() != en && owner(cell, t + 1) == coming)
+                continue;
+
+            float step = 1.f;
+
+            if(move.x() != 0 && move.y() != 0)
+                step = (float)M_SQRT2;
+
+            float found_g = current_g + step + (move == vec2i{0, 0} ? 0 : cost);
+
+            int next_state = state_of(next_cell, depth + 1);
+
+            auto it = g_score.find(next_state);
+
+            if(it != g_score.end() && found_g >= it->second)
+                continue;
+
+            g_score[next_state] = found_g;
+            came_from[next_state] = current;
+
+            open.push({found_g + h(next), next_state});
+        }
+    }
+
+    std::vector<vec2i> ret;
+
+    ///boxed in for the whole window, stand still and hope
+    if(found == -1)
+    {
+        for(int i = 0; i <= window; i++)
+        {
+            if(!is_free(start_cell, now + i, en))
+                break;
+
+            ret.push_back(start);
+        }
+    }
+    else
+    {
+        for(int current = found; current != -1; current = came_from[current])
+        {
+            int cell = current % size;
+
+            ret.push_back({cell % width, cell / width});
+        }
+
+        std::reverse(ret.begin(), ret.end());
+    }
+
+    for(int i = 0; i < (int)ret.size(); i++)
+    {
+        reserve(ret[i].y() * width + ret[i].x(), now + i, en);
+    }
+
+    return ret;
+}
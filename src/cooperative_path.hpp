@@ -0,0 +1,49 @@
+#ifndef COOPERATIVE_PATH_HPP_INCLUDED
+#define COOPERATIVE_PATH_HPP_INCLUDED
+
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <optional>
+#include <stdint.h>
+#include <vec/vec.hpp>
+#include <entt/entt.hpp>
+
+struct tilemap;
+
+///windowed cooperative pathfinding (WHCA*). Units reserve the tiles they'll stand on for the next few steps,
+///and plan around everyone else's reservations, so nobody ends up sharing a tile. Lives on the battle map entity
+///all units step together in batches, one batch per step, rather than each on their own timer
+struct reservation_table
+{
+    bool enabled = true;
+
+    ///how many steps ahead each unit plans and reserves
+    int window = 8;
+
+    float time_between_steps = 1.;
+    float time_left_before_step = time_between_steps;
+
+    ///the step the current batch is moving away from
+    uint64_t now = 0;
+
+    std::unordered_map<uint64_t, entt::entity> slots;
+    std::map<entt::entity, std::vector<uint64_t>> owned;
+
+    ///true when it's time for a batch of steps
+    bool tick(float delta_time);
+    ///call once everyone in the batch has moved
+    void end_step();
+
+    std::optional<entt::entity> owner(int cell, uint64_t t) const;
+    bool is_free(int cell, uint64_t t, entt::entity en) const;
+
+    void reserve(int cell, uint64_t t, entt::entity en);
+    void release(entt::entity en);
+
+    ///where en stands for each of the next window steps, starting from where it is now, heading for waypoint
+    ///space time A* around everyone else's reservations, with waiting in place as a move. Everything it returns gets reserved
+    std::vector<vec2i> plan(const tilemap& tmap, entt::entity en, vec2i start, vec2i waypoint);
+};
+
+#endif // COOPERATIVE_PATH_HPP_INCLUDED
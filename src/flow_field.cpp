@@ -0,0 +1,164 @@
+#include "flow_field.hpp"
+
+#include <algorithm>
+#include "tilemap.hpp"
+#include "battle_map.hpp"
+
+void flow_field::build(const tilemap& tmap, const std::vector<int>& goal_tiles)
+{
+    dim = tmap.dim;
+    goals = goal_tiles;
+    known_static = tmap.static_cost;
+    cost_cursor = tmap.cost_revision();
+
+    int size = dim.x() * dim.y();
+
+    distance.assign(size, FLT_MAX);
+    next.assign(size, -1);
+
+    open.resize(size);
+    open.clear();
+
+    for(int idx : goals)
+    {
+        distance[idx] = 0;
+        open.push_or_decrease(idx, 0, 0);
+    }
+
+    ///this runs backwards from the goals, so stepping from a neighbour into current costs current's tile cost
+    while(!open.empty())
+    {
+        int current = open.pop();
+
+        vec2i pos = {current % dim.x(), current / dim.x()};
+
+        ///goals are never stepped onto, so whatever is standing there doesn't block the field
+        int current_cost = distance[current] == 0 ? 0 : known_static[current];
+
+        if(current_cost == -1)
+            continue;
+
+        for(int dir = 0; dir < 8; dir++)
+        {
+            vec2i neighbour = pos - directions[dir];
+
+            if(neighbour.x() < 0 || neighbour.y() < 0 || neighbour.x() >= dim.x() || neighbour.y() >= dim.y())
+                continue;
+
+            int neighbour_idx = neighbour.y() * dim.x() + neighbour.x();
+
+            if(known_static[neighbour_idx] == -1)
+                continue;
+
+            float step = (dir >= 4) ? (float)M_SQRT2 : 1.f;
+            float found = distance[current] + step + current_cost;
+
+            if(found >= distance[neighbour_idx])
+                continue;
+
+            distance[neighbour_idx] = found;
+            next[neighbour_idx] = dir;
+
+            open.push_or_decrease(neighbour_idx, found, 0);
+        }
+    }
+}
+
+bool flow_field::terrain_changed(const tilemap& tmap)
+{
+    if(dim != tmap.dim)
+        return true;
+
+    bool changed = false;
+
+    ///the log has every unit stepping about in it too, but those cells' static costs haven't moved
+    bool caught_up = tmap.catch_up_cost_changes(cost_cursor, [&](int idx)
+    {
+        if(tmap.static_cost[idx] != known_static[idx])
+            changed = true;
+    });
+
+    if(!caught_up)
+        changed = known_static != tmap.static_cost;
+
+    return changed;
+}
+
+float flow_field::distance_at(vec2i pos) const
+{
+    if(pos.x() < 0 || pos.y() < 0 || pos.x() >= dim.x() || pos.y() >= dim.y())
+        return FLT_MAX;
+
+    return distance[pos.y() * dim.x() + pos.x()];
+}
+
+std::optional<vec2i> flow_field::next_step(vec2i pos) const
+{
+    if(pos.x() < 0 || pos.y() < 0 || pos.x() >= dim.x() || pos.y() >= dim.y())
+        return std::nullopt;
+
+    int dir = next[pos.y() * dim.x() + pos.x()];
+
+    if(dir == -1)
+        return std::nullopt;
+
+    return pos + directions[dir];
+}
+
+void team_flow_fields::begin_tick()
+{
+    tick++;
+}
+
+static bool is_on_tilemap(const tilemap& tmap, entt::entity en, vec2i pos)
+{
+    if(pos.x() < 0 || pos.y() < 0 || pos.x() >= tmap.dim.x() || pos.y() >= tmap.dim.y())
+        return false;
+
+    const auto& lst = tmap.all_entities[pos.y() * tmap.dim.x() + pos.x()];
+
+    return std::find(lst.begin(), lst.end(), en) != lst.end();
+}
+
+const flow_field& team_flow_fields::get(entt::registry& registry, const tilemap& tmap, int team_id)
+{
+    flow_field& field = fields[team_id];
+
+    if(field.built_tick == tick)
+        return field;
+
+    field.built_tick = tick;
+
+    std::vector<int> goals;
+
+    auto view = registry.view<team, battle_map::battle_unit_info, battle_tag, damageable, tilemap_position>();
+
+    for(auto ent : view)
+    {
+        if(view.get<team>(ent).t == team_id)
+            continue;
+
+        if(view.get<damageable>(ent).cur_hp <= 0)
+            continue;
+
+        vec2i pos = view.get<tilemap_position>(ent).pos;
+
+        if(!is_on_tilemap(tmap, ent, pos))
+            continue;
+
+        goals.push_back(pos.y() * tmap.dim.x() + pos.x());
+    }
+
+    std::sort(goals.begin(), goals.end());
+    goals.erase(std::unique(goals.begin(), goals.end()), goals.end());
+
+    ///terrain_changed has to run every time to keep its cursor moving
+    bool terrain_changed = field.terrain_changed(tmap);
+
+    if(goals == field.goals && !terrain_changed)
+        return field;
+
+    field.build(tmap, goals);
+
+    return field;
+}
@@ -0,0 +1,56 @@
+#ifndef FLOW_FIELD_HPP_INCLUDED
+#define FLOW_FIELD_HPP_INCLUDED
+
+#include <vector>
+#include <map>
+#include <optional>
+#include <stdint.h>
+#include <vec/vec.hpp>
+#include <entt/entt.hpp>
+#include "pathfinding.hpp"
+
+struct tilemap;
+
+///dijkstra map from a set of goal tiles. Every tile knows which way to step to get closer to the nearest goal
+///built over static costs only, units standing about are left to the reservations and cooperative steps, so they don't force rebuilds
+struct flow_field
+{
+    static inline const vec2i directions[8] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+
+    vec2i dim = {0, 0};
+
+    ///cost to the nearest goal, FLT_MAX if there's no way there
+    std::vector<float> distance;
+    ///index into directions, -1 for goals and unreachable tiles
+    std::vector<int8_t> next;
+
+    ///what the field was last built from
+    std::vector<int> goals;
+    std::vector<int16_t> known_static;
+    uint64_t cost_cursor = 0;
+    uint64_t built_tick = -1;
+
+    indexed_heap open;
+
+    void build(const tilemap& tmap, const std::vector<int>& goal_tiles);
+
+    ///whether the terrain's changed since the field was built, anything else on the map moving about doesn't count
+    bool terrain_changed(const tilemap& tmap);
+
+    float distance_at(vec2i pos) const;
+    std::optional<vec2i> next_step(vec2i pos) const;
+};
+
+///one flow field per team on a battle map, flowing towards every living enemy. Lives on the battle map entity
+struct team_flow_fields
+{
+    std::map<int, flow_field> fields;
+    uint64_t tick = 0;
+
+    ///fields are rebuilt at most once per tick, and only if the tiles the enemies are standing on or the terrain have changed
+    void begin_tick();
+
+    const flow_field& get(entt::registry& registry, const tilemap& tmap, int team_id);
+};
+
+#endif // FLOW_FIELD_HPP_INCLUDED
@@ -0,0 +1,293 @@
+#include "incremental_path.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include "tilemap.hpp"
+
+///same order as get_shortest_path, so ties come out the same way
+static const vec2i offsets[8] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+
+float incremental_path::g_of(int idx) const
+{
+    auto it = nodes.find(idx);
+
+    return it == nodes.end() ? FLT_MAX : it->second.g;
+}
+
+float incremental_path::rhs_of(int idx) const
+{
+    auto it = nodes.find(idx);
+
+    return it == nodes.end() ? FLT_MAX : it->second.rhs;
+}
+
+incremental_path::node& incremental_path::get(int idx)
+{
+    return nodes.try_emplace(idx, node{FLT_MAX, FLT_MAX}).first->second;
+}
+
+float incremental_path::heuristic(int a, int b) const
+{
+    vec2i pa = {a % dim.x(), a / dim.x()};
+    vec2i pb = {b % dim.x(), b / dim.x()};
+
+    ///shaved a little, straight line distance can round up past the float sum of the steps along it
+    ///and a heuristic that's inconsistent by even that much can stop a repair before a stale g gets fixed
+    return (pa - pb).length() * 0.999f;
+}
+
+bool incremental_path::key_less(float a1, float a2, float b1, float b2) const
+{
+    if(a1 != b1)
+        return a1 < b1;
+
+    return a2 < b2;
+}
+
+void incremental_path::set_key(int idx)
+{
+    node& n = get(idx);
+
+    float best = std::min(n.g, n.rhs);
+    int start_idx = start.y() * dim.x() + start.x();
+
+    n.k1 = best + heuristic(start_idx, idx) + km;
+    n.k2 = best;
+    n.queued = true;
+
+    open.push({n.k1, n.k2, idx});
+}
+
+void incremental_path::dequeue(int idx)
+{
+    auto it = nodes.find(idx);
+
+    if(it != nodes.end())
+        it->second.queued = false;
+}
+
+bool incremental_path::settle_top()
+{
+    while(!open.empty())
+    {
+        const open_entry& top = open.top();
+
+        auto it = nodes.find(top.idx);
+
+        if(it != nodes.end() && it->second.queued && it->second.k1 == top.k1 && it->second.k2 == top.k2)
+            return true;
+
+        open.pop();
+    }
+
+    return false;
+}
+
+float incremental_path::best_successor(int idx, int* out) const
+{
+    vec2i pos = {idx % dim.x(), idx / dim.x()};
+
+    float best = FLT_MAX;
+
+    for(const vec2i& offset : offsets)
+    {
+        vec2i next = pos + offset;
+
+        if(next.x() < 0 || next.y() < 0 || next.x() >= dim.x() || next.y() >= dim.y())
+            continue;
+
+        int next_idx = next.y() * dim.x() + next.x();
+
+        int cost = costs[next_idx];
+
+        if(cost == -1)
+            continue;
+
+        float next_g = g_of(next_idx);
+
+        if(next_g == FLT_MAX)
+            continue;
+
+        float step = (offset.x() != 0 && offset.y() != 0) ? (float)M_SQRT2 : 1.f;
+        float found = next_g + step + cost;
+
+        if(found < best)
+        {
+            best = found;
+
+            if(out)
+                *out = next_idx;
+        }
+    }
+
+    return best;
+}
+
+void incremental_path::update_vertex(int idx)
+{
+    int goal_idx = goal.y() * dim.x() + goal.x();
+
+    float rhs = (idx == goal_idx) ? rhs_of(idx) : best_successor(idx, nullptr);
+
+    auto it = nodes.find(idx);
+
+    ///still unreachable and never touched, no need to start keeping track of it
+    if(it == nodes.end() && rhs == FLT_MAX)
+        return;
+
+    node& n = get(idx);
+    n.rhs = rhs;
+
+    if(n.g != n.rhs)
+        set_key(idx);
+    else
+        n.queued = false;
+}
+
+void incremental_path::touch_neighbours(int idx)
+{
+    vec2i pos = {idx % dim.x(), idx / dim.x()};
+
+    for(const vec2i& offset : offsets)
+    {
+        vec2i next = pos + offset;
+
+        if(next.x() < 0 || next.y() < 0 || next.x() >= dim.x() || next.y() >= dim.y())
+            continue;
+
+        update_vertex(next.y() * dim.x() + next.x());
+    }
+}
+
+void incremental_path::reset(const tilemap& tmap, vec2i _start, vec2i _goal)
+{
+    dim = tmap.dim;
+    goal = _goal;
+    start = _start;
+    last_start = _start;
+    km = 0;
+    cost_cursor = tmap.cost_revision();
+    costs = tmap.path_cost.data();
+
+    nodes.clear();
+    open = {};
+
+    int goal_idx = goal.y() * dim.x() + goal.x();
+
+    get(goal_idx).rhs = 0;
+    set_key(goal_idx);
+}
+
+void incremental_path::compute()
+{
+    int start_idx = start.y() * dim.x() + start.x();
+
+    last_expanded = 0;
+
+    while(settle_top())
+    {
+        open_entry top = open.top();
+
+        float start_g = g_of(start_idx);
+        float start_rhs = rhs_of(start_idx);
+        float start_best = std::min(start_g, start_rhs);
+        float start_k1 = start_best == FLT_MAX ? FLT_MAX : start_best + km;
+
+        bool before_start = key_less(top.k1, top.k2, start_k1, start_best);
+
+        if(!before_start && start_rhs == start_g)
+            break;
+
+        int current = top.idx;
+        node& n = get(current);
+
+        float best = std::min(n.g, n.rhs);
+        float new_k1 = best + heuristic(start_idx, current) + km;
+
+        last_expanded++;
+
+        ///the start has moved on since this was queued
+        if(key_less(top.k1, top.k2, new_k1, best))
+        {
+            set_key(current);
+            continue;
+        }
+
+        open.pop();
+        n.queued = false;
+
+        if(n.g > n.rhs)
+        {
+            n.g = n.rhs;
+        }
+        else
+        {
+            n.g = FLT_MAX;
+            update_vertex(current);
+        }
+
+        ///anything next to current can step into it, so their rhs could have changed
+        touch_neighbours(current);
+    }
+}
+
+std::vector<vec2i> incremental_path::replan(const tilemap& tmap, vec2i _start)
+{
+    if(dim != tmap.dim)
+        reset(tmap, _start, goal);
+
+    costs = tmap.path_cost.data();
+    start = _start;
+
+    int start_idx = start.y() * dim.x() + start.x();
+    int last_idx = last_start.y() * dim.x() + last_start.x();
+
+    km += heuristic(last_idx, start_idx);
+    last_start = start;
+
+    std::vector<int> changed;
+
+    bool caught_up = tmap.catch_up_cost_changes(cost_cursor, [&](int idx)
+    {
+        changed.push_back(idx);
+    });
+
+    ///too far behind to repair, start over
+    if(!caught_up)
+        reset(tmap, _start, goal);
+
+    ///a tile's cost is what it costs to step into it, so it's the neighbours whose rhs need another look
+    for(int idx : changed)
+    {
+        touch_neighbours(idx);
+    }
+
+    compute();
+
+    std::vector<vec2i> ret;
+
+    if(g_of(start_idx) == FLT_MAX)
+        return ret;
+
+    int goal_idx = goal.y() * dim.x() + goal.x();
+    int current = start_idx;
+
+    ret.push_back(start);
+
+    ///each step strictly lowers g, but a bad repair shouldn't be able to hang us
+    while(current != goal_idx && (int)ret.size() <= dim.x() * dim.y())
+    {
+        int next = -1;
+
+        if(best_successor(current, &next) == FLT_MAX)
+            return {};
+
+        current = next;
+        ret.push_back({current % dim.x(), current / dim.x()});
+    }
+
+    if(current != goal_idx)
+        return {};
+
+    return ret;
+}
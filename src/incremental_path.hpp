@@ -0,0 +1,87 @@
+#ifndef INCREMENTAL_PATH_HPP_INCLUDED
+#define INCREMENTAL_PATH_HPP_INCLUDED
+
+#include <vector>
+#include <queue>
+#include <unordered_map>
+#include <stdint.h>
+#include <vec/vec.hpp>
+
+struct tilemap;
+
+///D* Lite - searches backwards from the goal once, then repairs only the tiles whose costs have changed since
+///the start is free to move along the path between repairs. Changing the goal throws everything away
+///step costs match a_star: entering a tile costs its path cost on top of the distance moved
+///state is only kept for tiles the search has touched, so lots of units can each own one and a reset doesn't cost a whole map
+struct incremental_path
+{
+    vec2i dim = {0, 0};
+    vec2i goal = {-1, -1};
+    vec2i start = {-1, -1};
+    ///start at the last repair, for the key modifier
+    vec2i last_start = {-1, -1};
+    float km = 0;
+
+    struct node
+    {
+        float g;
+        float rhs;
+        ///the key it's queued under, entries in open that don't match this are stale
+        float k1 = 0;
+        float k2 = 0;
+        bool queued = false;
+    };
+
+    ///anything missing has g == rhs == infinity
+    std::unordered_map<int, node> nodes;
+
+    struct open_entry
+    {
+        float k1;
+        float k2;
+        int idx;
+
+        bool operator>(const open_entry& other) const
+        {
+            if(k1 != other.k1)
+                return k1 > other.k1;
+
+            return k2 > other.k2;
+        }
+    };
+
+    ///lazily deleted, set_key pushes a fresh entry rather than fixing the old one up
+    std::priority_queue<open_entry, std::vector<open_entry>, std::greater<open_entry>> open;
+    uint64_t cost_cursor = 0;
+
+    ///how many tiles the last repair expanded
+    int last_expanded = 0;
+
+    bool tracking(vec2i _goal) const {return nodes.size() > 0 && goal == _goal;}
+
+    ///starts again from scratch towards a new goal
+    void reset(const tilemap& tmap, vec2i _start, vec2i _goal);
+    ///catches up with cost changes and a moved start, then returns the path from start to goal, inclusive. Empty if there's no way
+    std::vector<vec2i> replan(const tilemap& tmap, vec2i _start);
+
+private:
+    ///the tilemap's costs for the duration of a replan. Every change gets caught up before searching, so these are always what the search is consistent with
+    const int16_t* costs = nullptr;
+
+    float g_of(int idx) const;
+    float rhs_of(int idx) const;
+    node& get(int idx);
+
+    float heuristic(int a, int b) const;
+    void set_key(int idx);
+    void dequeue(int idx);
+    ///drops stale entries off the top, returns false if there's nothing left
+    bool settle_top();
+    bool key_less(float a1, float a2, float b1, float b2) const;
+    float best_successor(int idx, int* out) const;
+    void update_vertex(int idx);
+    void touch_neighbours(int idx);
+    void compute();
+};
+
+#endif // INCREMENTAL_PATH_HPP_INCLUDED
@@ -0,0 +1,483 @@
+#include "jump_point_search.hpp"
+
+#include <map>
+#include <algorithm>
+#include "tilemap.hpp"
+
+int cardinal_index(vec2i dir)
+{
+    if(dir.x() > 0)
+        return 0;
+
+    if(dir.x() < 0)
+        return 1;
+
+    if(dir.y() > 0)
+        return 2;
+
+    return 3;
+}
+
+vec2i sign(vec2i in)
+{
+    return {(in.x() > 0) - (in.x() < 0), (in.y() > 0) - (in.y() < 0)};
+}
+
+bool is_weighted_cost(int cost, int uniform_cost)
+{
+    return cost != -1 && cost != uniform_cost;
+}
+
+bool jump_point_table::is_open(vec2i pos) const
+{
+    if(pos.x() < 0 || pos.y() < 0 || pos.x() >= dim.x() || pos.y() >= dim.y())
+        return false;
+
+    return flags[pos.y() * dim.x() + pos.x()] & OPEN;
+}
+
+bool jump_point_table::is_forced(vec2i pos, vec2i dir) const
+{
+    if(dir.x() != 0 && dir.y() != 0)
+    {
+        return (!is_open(pos + vec2i{-dir.x(), 0}) && is_open(pos + vec2i{-dir.x(), dir.y()})) ||
+               (!is_open(pos + vec2i{0, -dir.y()}) && is_open(pos + vec2i{dir.x(), -dir.y()}));
+    }
+
+    vec2i perp = {dir.y(), dir.x()};
+
+    return (!is_open(pos + perp) && is_open(pos + perp + dir)) ||
+           (!is_open(pos - perp) && is_open(pos - perp + dir));
+}
+
+void jump_point_table::update_flags(const tilemap& tmap, int idx)
+{
+    int cost = tmap.path_cost[idx];
+
+    uint8_t next = 0;
+
+    if(cost == uniform_cost)
+        next |= OPEN;
+    else if(cost != -1)
+        next |= WEIGHTED;
+
+    int x = idx % dim.x();
+    int y = idx / dim.x();
+
+    for(int dy = -1; dy <= 1; dy++)
+    {
+        for(int dx = -1; dx <= 1; dx++)
+        {
+            int ox = x + dx;
+            int oy = y + dy;
+
+            if((dx == 0 && dy == 0) || ox < 0 || oy < 0 || ox >= dim.x() || oy >= dim.y())
+                continue;
+
+            if(is_weighted_cost(tmap.path_cost[oy * dim.x() + ox], uniform_cost))
+                next |= NEAR_WEIGHTED;
+        }
+    }
+
+    weighted_cells += (int)((next & WEIGHTED) != 0) - (int)((flags[idx] & WEIGHTED) != 0);
+
+    flags[idx] = next;
+}
+
+void jump_point_table::rebuild_row(int y)
+{
+    for(int dir = 0; dir < 2; dir++)
+    {
+        std::vector<int16_t>& dist = distance[dir];
+
+        int step = cardinals[dir].x();
+        int first = step > 0 ? dim.x() - 1 : 0;
+
+        for(int x = first; x >= 0 && x < dim.x(); x -= step)
+        {
+            vec2i next = {x + step, y};
+            int idx = y * dim.x() + x;
+
+            if(!is_open(next))
+            {
+                dist[idx] = 0;
+                continue;
+            }
+
+            int next_idx = next.y() * dim.x() + next.x();
+
+            ///a run too long for an int16 gets broken up, stopping at next is always safe, just not as far
+            if((flags[next_idx] & NEAR_WEIGHTED) || is_forced(next, cardinals[dir]) || abs(dist[next_idx]) >= INT16_MAX)
+            {
+                dist[idx] = 1;
+                continue;
+            }
+
+            dist[idx] = dist[next_idx] > 0 ? dist[next_idx] + 1 : dist[next_idx] - 1;
+        }
+    }
+}
+
+void jump_point_table::rebuild_column(int x)
+{
+    for(int dir = 2; dir < 4; dir++)
+    {
+        std::vector<int16_t>& dist = distance[dir];
+
+        int step = cardinals[dir].y();
+        int first = step > 0 ? dim.y() - 1 : 0;
+
+        for(int y = first; y >= 0 && y < dim.y(); y -= step)
+        {
+            vec2i next = {x, y + step};
+            int idx = y * dim.x() + x;
+
+            if(!is_open(next))
+            {
+                dist[idx] = 0;
+                continue;
+            }
+
+            int next_idx = next.y() * dim.x() + next.x();
+
+            ///a run too long for an int16 gets broken up, stopping at next is always safe, just not as far
+            if((flags[next_idx] & NEAR_WEIGHTED) || is_forced(next, cardinals[dir]) || abs(dist[next_idx]) >= INT16_MAX)
+            {
+                dist[idx] = 1;
+                continue;
+            }
+
+            dist[idx] = dist[next_idx] > 0 ? dist[next_idx] + 1 : dist[next_idx] - 1;
+        }
+    }
+}
+
+void jump_point_table::rebuild(const tilemap& tmap)
+{
+    dim = tmap.dim;
+    cost_cursor = tmap.cost_revision();
+
+    int size = dim.x() * dim.y();
+
+    ///the most common walkable cost is the one worth jumping over
+    std::map<int, int> cost_counts;
+
+    for(int16_t cost : tmap.path_cost)
+    {
+        if(cost != -1)
+            cost_counts[cost]++;
+    }
+
+    uniform_cost = 0;
+    int best_count = 0;
+
+    for(auto& [cost, count] : cost_counts)
+    {
+        if(count > best_count)
+        {
+            uniform_cost = cost;
+            best_count = count;
+        }
+    }
+
+    flags.assign(size, 0);
+    weighted_cells = 0;
+
+    for(auto& dist : distance)
+    {
+        dist.assign(size, 0);
+    }
+
+    for(int idx = 0; idx < size; idx++)
+    {
+        update_flags(tmap, idx);
+    }
+
+    for(int y = 0; y < dim.y(); y++)
+    {
+        rebuild_row(y);
+    }
+
+    for(int x = 0; x < dim.x(); x++)
+    {
+        rebuild_column(x);
+    }
+
+    dirty_rows.assign(dim.y(), 0);
+    dirty_columns.assign(dim.x(), 0);
+}
+
+void jump_point_table::update(const tilemap& tmap)
+{
+    if(dim != tmap.dim || (int)flags.size() != dim.x() * dim.y())
+    {
+        rebuild(tmap);
+        return;
+    }
+
+    bool caught_up = tmap.catch_up_cost_changes(cost_cursor, [&](int idx)
+    {
+        int x = idx % dim.x();
+        int y = idx / dim.x();
+
+        ///a cell's flags depend on its neighbours, and a row's jump distances on the rows either side of it
+        for(int dy = -1; dy <= 1; dy++)
+        {
+            for(int dx = -1; dx <= 1; dx++)
+            {
+                int ox = x + dx;
+                int oy = y + dy;
+
+                if(ox < 0 || oy < 0 || ox >= dim.x() || oy >= dim.y())
+                    continue;
+
+                update_flags(tmap, oy * dim.x() + ox);
+
+                dirty_rows[oy] = 1;
+                dirty_columns[ox] = 1;
+            }
+        }
+    });
+
+    if(!caught_up)
+    {
+        rebuild(tmap);
+        return;
+    }
+
+    for(int y = 0; y < dim.y(); y++)
+    {
+        if(!dirty_rows[y])
+            continue;
+
+        rebuild_row(y);
+        dirty_rows[y] = 0;
+    }
+
+    for(int x = 0; x < dim.x(); x++)
+    {
+        if(!dirty_columns[x])
+            continue;
+
+        rebuild_column(x);
+        dirty_columns[x] = 0;
+    }
+}
+
+///number of steps to the next jump point in a cardinal direction, 0 if there isn't one
+int jump_straight(const jump_point_table& table, vec2i from, vec2i dir, vec2i fin)
+{
+    int dist = table.distance[cardinal_index(dir)][from.y() * table.dim.x() + from.x()];
+    int reach = abs(dist);
+
+    ///the goal counts as a jump point if we pass over it
+    vec2i to_goal = fin - from;
+
+    int along = to_goal.x() * dir.x() + to_goal.y() * dir.y();
+    int across = to_goal.x() * dir.y() + to_goal.y() * dir.x();
+
+    if(across == 0 && along > 0 && along <= reach)
+        return along;
+
+    return std::max(dist, 0);
+}
+
+int jump_diagonal(const jump_point_table& table, vec2i from, vec2i dir, vec2i fin)
+{
+    vec2i horizontal = {dir.x(), 0};
+    vec2i vertical = {0, dir.y()};
+
+    vec2i next = from;
+    int steps = 0;
+
+    while(true)
+    {
+        next += dir;
+        steps++;
+
+        if(!table.is_open(next))
+            return 0;
+
+        if(next == fin)
+            return steps;
+
+        if(table.flags[next.y() * table.dim.x() + next.x()] & jump_point_table::NEAR_WEIGHTED)
+            return steps;
+
+        if(table.is_forced(next, dir))
+            return steps;
+
+        if(jump_straight(table, next, horizontal, fin) > 0 || jump_straight(table, next, vertical, fin) > 0)
+            return steps;
+    }
+}
+
+///jump points are always in a straight line or diagonal from their parent, so fill in the tiles in between
+std::vector<vec2i> reconstruct_jump_path(const path_search_state& state, int current)
+{
+    int width = state.dim.x();
+
+    std::vector<vec2i> total_path;
+
+    vec2i pos = {current % width, current / width};
+
+    total_path.push_back(pos);
+
+    while(state.came_from[current] != -1)
+    {
+        current = state.came_from[current];
+
+        vec2i parent = {current % width, current / width};
+        vec2i dir = sign(parent - pos);
+
+        while(pos != parent)
+        {
+            pos += dir;
+            total_path.push_back(pos);
+        }
+    }
+
+    std::reverse(total_path.begin(), total_path.end());
+
+    return total_path;
+}
+
+std::vector<vec2i> get_jump_point_path(tilemap& tmap, vec2i start, vec2i fin, int cap)
+{
+    if(start == fin)
+    {
+        return {start};
+    }
+
+    jump_point_table& table = tmap.jump_points;
+    path_search_state& state = tmap.search;
+
+    table.update(tmap);
+    state.begin(tmap.dim);
+
+    int width = tmap.dim.x();
+    int start_idx = start.y() * width + start.x();
+    int fin_idx = fin.y() * width + fin.x();
+
+    state.seen[start_idx] = state.generation;
+    state.g_score[start_idx] = 0.f;
+    state.came_from[start_idx] = -1;
+
+    float start_h = (start - fin).length();
+
+    state.open.push_or_decrease(start_idx, start_h, start_h);
+
+    static const vec2i all_directions[8] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+
+    int num_explored = 0;
+
+    while(!state.open.empty())
+    {
+        int current_idx = state.open.pop();
+
+        if(current_idx == fin_idx)
+            return reconstruct_jump_path(state, current_idx);
+
+        state.closed[current_idx] = state.generation;
+
+        vec2i current_sys = {current_idx % width, current_idx / width};
+        float current_g = state.g_score[current_idx];
+
+        vec2i directions[8];
+        int num_directions = 0;
+
+        int parent_idx = state.came_from[current_idx];
+
+        ///next to weighted tiles (and on them) we can't prune anything, so this is just A*
+        if(parent_idx == -1 || table.flags[current_idx] != jump_point_table::OPEN)
+        {
+            for(const vec2i& dir : all_directions)
+            {
+                directions[num_directions++] = dir;
+            }
+        }
+        else
+        {
+            vec2i parent = {parent_idx % width, parent_idx / width};
+            vec2i dir = sign(current_sys - parent);
+
+            auto add_forced = [&](vec2i blocked, vec2i forced)
+            {
+                if(!table.is_open(current_sys + blocked))
+                    directions[num_directions++] = forced;
+            };
+
+            if(dir.x() != 0 && dir.y() != 0)
+            {
+                directions[num_directions++] = {dir.x(), 0};
+                directions[num_directions++] = {0, dir.y()};
+                directions[num_directions++] = dir;
+
+                add_forced({-dir.x(), 0}, {-dir.x(), dir.y()});
+                add_forced({0, -dir.y()}, {dir.x(), -dir.y()});
+            }
+            else
+            {
+                vec2i perp = {dir.y(), dir.x()};
+
+                directions[num_directions++] = dir;
+
+                add_forced(perp, perp + dir);
+                add_forced(-perp, -perp + dir);
+            }
+        }
+
+        for(int i = 0; i < num_directions; i++)
+        {
+            vec2i dir = directions[i];
+            vec2i neighbour = current_sys + dir;
+
+            if(neighbour.x() < 0 || neighbour.y() < 0 || neighbour.x() >= tmap.dim.x() || neighbour.y() >= tmap.dim.y())
+                continue;
+
+            int neighbour_cost = tmap.path_cost[neighbour.y() * width + neighbour.x()];
+
+            if(neighbour_cost == -1)
+                continue;
+
+            float step = (dir.x() != 0 && dir.y() != 0) ? (float)M_SQRT2 : 1.f;
+
+            vec2i next_sys = neighbour;
+            float found_gscore = current_g + step + neighbour_cost;
+
+            if(table.is_open(neighbour))
+            {
+                int steps = (dir.x() != 0 && dir.y() != 0) ? jump_diagonal(table, current_sys, dir, fin) : jump_straight(table, current_sys, dir, fin);
+
+                if(steps == 0)
+                    continue;
+
+                next_sys = current_sys + dir * steps;
+                found_gscore = current_g + (step + table.uniform_cost) * steps;
+            }
+
+            int next_idx = next_sys.y() * width + next_sys.x();
+
+            if(state.is_closed(next_idx))
+                continue;
+
+            if(state.is_seen(next_idx) && found_gscore >= state.g_score[next_idx])
+                continue;
+
+            state.seen[next_idx] = state.generation;
+            state.came_from[next_idx] = current_idx;
+            state.g_score[next_idx] = found_gscore;
+
+            float h = (next_sys - fin).length();
+
+            state.open.push_or_decrease(next_idx, found_gscore + h, h);
+
+            num_explored++;
+
+            if(num_explored > cap && cap != -1)
+                return {};
+        }
+    }
+
+    return {};
+}
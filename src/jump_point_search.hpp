@@ -0,0 +1,58 @@
+#ifndef JUMP_POINT_SEARCH_HPP_INCLUDED
+#define JUMP_POINT_SEARCH_HPP_INCLUDED
+
+#include <vector>
+#include <array>
+#include <stdint.h>
+#include <vec/vec.hpp>
+
+struct tilemap;
+
+///precomputed straight jump distances for jump point search (JPS+)
+///a cell is open if its cost is the map's uniform cost. Anything else that can be walked on is treated as weighted,
+///and the search falls back to plain A* expansion around it
+struct jump_point_table
+{
+    enum flag
+    {
+        OPEN = 1,
+        WEIGHTED = 2,
+        NEAR_WEIGHTED = 4,
+    };
+
+    ///east, west, south, north
+    static inline const vec2i cardinals[4] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+    vec2i dim = {0, 0};
+    int16_t uniform_cost = 0;
+
+    std::vector<uint8_t> flags;
+    ///cells that can be walked on but aren't uniform_cost, which is where jumping stops paying off
+    int weighted_cells = 0;
+    ///steps to the next straight jump point, or minus the number of open steps before running into something
+    ///runs longer than INT16_MAX get an extra jump point part way along, so neither ever overflows
+    std::array<std::vector<int16_t>, 4> distance;
+
+    std::vector<uint8_t> dirty_rows;
+    std::vector<uint8_t> dirty_columns;
+    uint64_t cost_cursor = 0;
+
+    ///brings the table up to date with the tilemap's path costs
+    void update(const tilemap& tmap);
+
+    bool is_open(vec2i pos) const;
+    bool is_open(int idx) const {return flags[idx] & OPEN;}
+    bool is_forced(vec2i pos, vec2i dir) const;
+    ///few enough weighted cells that jumping beats plain A*. Only meaningful once update has been called
+    bool mostly_uniform() const {return weighted_cells * 20 <= dim.x() * dim.y();}
+
+private:
+    void rebuild(const tilemap& tmap);
+    void update_flags(const tilemap& tmap, int idx);
+    void rebuild_row(int y);
+    void rebuild_column(int x);
+};
+
+std::vector<vec2i> get_jump_point_path(tilemap& tmap, vec2i start, vec2i fin, int cap);
+
+#endif // JUMP_POINT_SEARCH_HPP_INCLUDED
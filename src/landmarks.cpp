@@ -0,0 +1,177 @@
+#include "landmarks.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include "tilemap.hpp"
+
+void landmark_table::set_candidates(const std::vector<vec2i>& positions)
+{
+    candidates = positions;
+    distance.clear();
+
+    choose_landmarks();
+}
+
+void landmark_table::choose_landmarks()
+{
+    landmarks.clear();
+
+    if(candidates.size() == 0)
+        return;
+
+    ///landmarks work best out on the edges, so start with whatever's furthest from the middle
+    vec2f centre = {0, 0};
+
+    for(vec2i pos : candidates)
+    {
+        centre += vec2f{pos.x(), pos.y()};
+    }
+
+    centre = centre / (float)candidates.size();
+
+    std::vector<float> nearest(candidates.size(), FLT_MAX);
+
+    for(int i = 0; i < (int)candidates.size(); i++)
+    {
+        nearest[i] = (vec2f{candidates[i].x(), candidates[i].y()} - centre).length();
+    }
+
+    ///then keep taking whichever candidate is furthest from every landmark so far
+    while((int)landmarks.size() < max_landmarks && (int)landmarks.size() < (int)candidates.size())
+    {
+        int best = std::max_element(nearest.begin(), nearest.end()) - nearest.begin();
+
+        if(nearest[best] <= 0)
+            break;
+
+        vec2i chosen = candidates[best];
+
+        landmarks.push_back(chosen);
+
+        for(int i = 0; i < (int)candidates.size(); i++)
+        {
+            float len = (vec2f{candidates[i].x(), candidates[i].y()} - vec2f{chosen.x(), chosen.y()}).length();
+
+            nearest[i] = std::min(nearest[i], len);
+        }
+    }
+}
+
+void landmark_table::rebuild(const tilemap& tmap)
+{
+    dim = tmap.dim;
+    cost_cursor = tmap.cost_revision();
+    known_static = tmap.static_cost;
+
+    int size = dim.x() * dim.y();
+
+    static const vec2i offsets[8] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+
+    indexed_heap open;
+    open.resize(size);
+
+    distance.assign(landmarks.size(), {});
+
+    ///plain dijkstra out from each landmark, with the same step costs as a_star
+    for(int l = 0; l < (int)landmarks.size(); l++)
+    {
+        std::vector<float>& dist = distance[l];
+
+        dist.assign(size, FLT_MAX);
+        open.clear();
+
+        int source = landmarks[l].y() * dim.x() + landmarks[l].x();
+
+        dist[source] = 0;
+        open.push_or_decrease(source, 0, 0);
+
+        while(!open.empty())
+        {
+            int current = open.pop();
+
+            vec2i pos = {current % dim.x(), current / dim.x()};
+
+            for(const vec2i& offset : offsets)
+            {
+                vec2i next = pos + offset;
+
+                if(next.x() < 0 || next.y() < 0 || next.x() >= dim.x() || next.y() >= dim.y())
+                    continue;
+
+                int next_idx = next.y() * dim.x() + next.x();
+
+                int cost = known_static[next_idx];
+
+                if(cost == -1)
+                    continue;
+
+                float step = (offset.x() != 0 && offset.y() != 0) ? (float)M_SQRT2 : 1.f;
+                float found = dist[current] + step + cost;
+
+                if(found >= dist[next_idx])
+                    continue;
+
+                dist[next_idx] = found;
+                open.push_or_decrease(next_idx, found, 0);
+            }
+        }
+    }
+}
+
+///blocked counts as infinitely expensive
+static bool is_cheaper(int16_t now, int16_t built)
+{
+    if(now == -1)
+        return false;
+
+    return built == -1 || now < built;
+}
+
+void landmark_table::update(const tilemap& tmap)
+{
+    if(landmarks.size() == 0)
+        return;
+
+    if(dim != tmap.dim || distance.size() != landmarks.size())
+    {
+        rebuild(tmap);
+        return;
+    }
+
+    ///terrain getting dearer only makes the bounds looser, it's a tile getting cheaper than it was that would make them overestimate
+    ///so known_static is left as what the tables were built from, and compared against that
+    bool got_cheaper = false;
+
+    bool caught_up = tmap.catch_up_cost_changes(cost_cursor, [&](int idx)
+    {
+        if(is_cheaper(tmap.static_cost[idx], known_static[idx]))
+            got_cheaper = true;
+    });
+
+    if(!caught_up)
+    {
+        for(int idx = 0; idx < (int)known_static.size() && !got_cheaper; idx++)
+        {
+            got_cheaper = is_cheaper(tmap.static_cost[idx], known_static[idx]);
+        }
+    }
+
+    if(got_cheaper)
+        rebuild(tmap);
+}
+
+float landmark_table::lower_bound(int idx, int fin_idx) const
+{
+    float best = 0;
+
+    for(const std::vector<float>& dist : distance)
+    {
+        ///no information from a landmark that can't see both ends
+        if(dist[idx] == FLT_MAX || dist[fin_idx] == FLT_MAX)
+            continue;
+
+        best = std::max(best, dist[fin_idx] - dist[idx]);
+    }
+
+    return best;
+}
@@ -0,0 +1,42 @@
+#ifndef LANDMARKS_HPP_INCLUDED
+#define LANDMARKS_HPP_INCLUDED
+
+#include <vector>
+#include <stdint.h>
+#include <vec/vec.hpp>
+
+struct tilemap;
+
+///ALT - exact travel costs from a handful of landmark tiles to everywhere else
+///for any landmark L, getting from n to t costs at least d(L, t) - d(L, n), which is a far better bound than a straight line around coastlines
+///built from static costs only, which path costs never undercut, so armies moving about never force a rebuild
+///nothing gets built until the first search that wants a bound, which on the overworld is an army's march. After that only terrain getting cheaper forces a rebuild
+struct landmark_table
+{
+    static constexpr int max_landmarks = 8;
+
+    ///where landmarks can go, ie castles and towns. Nothing gets built until there are some
+    std::vector<vec2i> candidates;
+    std::vector<vec2i> landmarks;
+
+    vec2i dim = {0, 0};
+    ///distance[landmark][tile], FLT_MAX where the landmark can't get to
+    std::vector<std::vector<float>> distance;
+
+    ///the static costs the tables were built from. Anything at or above these everywhere leaves the tables admissible
+    std::vector<int16_t> known_static;
+    uint64_t cost_cursor = 0;
+
+    void set_candidates(const std::vector<vec2i>& positions);
+    ///builds the tables the first time, then rebuilds them if anything's got cheaper underneath them
+    void update(const tilemap& tmap);
+
+    bool ready() const {return distance.size() > 0;}
+    float lower_bound(int idx, int fin_idx) const;
+
+private:
+    void choose_landmarks();
+    void rebuild(const tilemap& tmap);
+};
+
+#endif // LANDMARKS_HPP_INCLUDED
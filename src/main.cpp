@@ -26,6 +26,7 @@
 #include "battle_map_ai.hpp"
 #include "overworld_map.hpp"
 #include "overworld_generation.hpp"
+#include "overworld_streaming.hpp"
 
 #include "Editor/imgui_bezier.hpp"
 #include "vfx/particle_system.hpp"
@@ -53,6 +54,18 @@ std::optional<entt::entity> scene_selector(entt::registry& registry)
 
             idx++;
         }
+
+        auto streamed_view = registry.view<streamed_overworld>();
+
+        for (auto ent : streamed_view)
+        {
+            if (ImGui::Button(std::to_string(idx).c_str()))
+            {
+                ret = ent;
+            }
+
+            idx++;
+        }
     }
 
     {
@@ -96,6 +109,9 @@ void battle_starter(entt::registry& registry)
                     std::vector<entt::entity> root;
                     std::vector<entt::entity> others;
 
+                    if(tmap.dynamic_occupancy[y * tmap.dim.x() + x] == 0)
+                        continue;
+
                     for(auto en2 : tmap.all_entities[y * tmap.dim.x() + x])
                     {
                         if(!registry.has<unit_group>(en2))
@@ -121,7 +137,8 @@ void battle_starter(entt::registry& registry)
                             int ox = dx + x;
                             int oy = dy + y;
 
-                            if(ox < 0 || oy < 0 || ox >= tmap.dim.x() || oy >= tmap.dim.y())
+                            ///the ring round the outside is never occupied, so this covers the edges too
+                            if(tmap.padded_occupancy[tmap.padded_index({ox, oy})] == 0)
                                 continue;
 
                             for(auto en2 : tmap.all_entities[oy * tmap.dim.x() + ox])
@@ -179,6 +196,9 @@ void battle_generator(entt::registry& registry, random_state& rng, std::array<in
 int main(int argc, char* argv[])
 {
     bool no_viewports = false;
+    ///world size for a streamed overworld, 0 to generate the whole thing up front
+    int streamed_size = 0;
+    uint64_t world_seed = std::minstd_rand::default_seed;
 
     if (argc > 1)
     {
@@ -192,6 +212,20 @@ int main(int argc, char* argv[])
 
                 printf("Viewports are disabled\n");
             }
+
+            if (sarg == "-streamed" && i + 1 < argc)
+            {
+                streamed_size = std::stoi(argv[++i]);
+
+                printf("Streaming a %ix%i overworld\n", streamed_size, streamed_size);
+            }
+
+            if (sarg == "-seed" && i + 1 < argc)
+            {
+                world_seed = std::stoull(argv[++i]);
+
+                printf("World seed %llu\n", (unsigned long long)world_seed);
+            }
         }
     }
 
@@ -209,6 +243,7 @@ int main(int argc, char* argv[])
     sprite_renderer sprite_render;
 
     random_state rng;
+    rng.set_seed(world_seed);
 
     /*sprite_handle dummy;
     dummy = get_sprite_handle_of(rng, tiles::TREE_1);
@@ -221,14 +256,17 @@ int main(int argc, char* argv[])
 
     entt::registry& registry = get_thread_local_registry();
 
-    entt::entity overworld = create_overworld(registry, rng, {150, 150});
+    entt::entity overworld = streamed_size > 0 ? create_streamed_overworld(registry, rng, {streamed_size, streamed_size}) : create_overworld(registry, rng, {150, 150});
     entt::entity default_battle = battle_map::create_battle(registry, rng, { 30, 30 }, level_info::GRASS);
     entt::entity& focused_tilemap = overworld;
 
     //battle editor variables
     std::array<int, 2> battle_size = { 50, 50 };
 
-    debug_overworld(registry, overworld, rng);
+    if (registry.has<tilemap>(overworld))
+        debug_overworld(registry, overworld, rng);
+    else
+        cam.pos = vec2f{ streamed_size/2, streamed_size/2 } * TILE_PIX;
 
     #ifdef TEST_OVERWORLD
     focused_tilemap = overworld;
@@ -300,8 +338,8 @@ int main(int argc, char* argv[])
             focused_tilemap = val.value();
 
             //centre camera on the new scen       
-            tilemap& tmap = registry.get<tilemap>(focused_tilemap);
-            cam.pos = vec2f{ tmap.dim.x()/2, tmap.dim.y()/2 } * TILE_PIX;
+            vec2i scene_dim = registry.has<tilemap>(focused_tilemap) ? registry.get<tilemap>(focused_tilemap).dim : registry.get<streamed_overworld>(focused_tilemap).world_dim;
+            cam.pos = vec2f{ scene_dim.x()/2, scene_dim.y()/2 } * TILE_PIX;
         }
 
         //Update battle maps
@@ -323,8 +361,21 @@ int main(int argc, char* argv[])
         //map
         battle_starter(registry);
 
-        tilemap& focused = registry.get<tilemap>(focused_tilemap);
-        focused.render(registry, win, cam, sprite_render, mpos);
+        if (registry.has<streamed_overworld>(focused_tilemap))
+        {
+            streamed_overworld& streamed = registry.get<streamed_overworld>(focused_tilemap);
+            streamed.update(registry, win, cam);
+            streamed.render(registry, win, cam, sprite_render, mpos);
+        }
+        else
+        {
+            tilemap& focused = registry.get<tilemap>(focused_tilemap);
+
+            if (registry.has<overworld_tag>(focused_tilemap))
+                update_overworld_armies(registry, focused, win, cam, mpos, delta_time);
+
+            focused.render(registry, win, cam, sprite_render, mpos);
+        }
 
         //vfx
         snow.editor();
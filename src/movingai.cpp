@@ -0,0 +1,139 @@
+#include "movingai.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <toolkit/fs_helpers.hpp>
+#include "random.hpp"
+#include "tilemap.hpp"
+#include "entity_common.hpp"
+
+static std::string read_movingai_file(const std::string& filename)
+{
+    std::string data = file::read(filename, file::mode::BINARY);
+
+    if(data.size() == 0)
+        throw std::runtime_error("Could not read " + filename);
+
+    ///the benchmark files are about half windows line endings
+    std::string ret;
+    ret.reserve(data.size());
+
+    for(char c : data)
+    {
+        if(c != '\r')
+            ret.push_back(c);
+    }
+
+    return ret;
+}
+
+static tiles::type movingai_obstacle_tile(char c)
+{
+    if(c == 'T')
+        return tiles::TREE_1;
+
+    if(c == 'W')
+        return tiles::WATER;
+
+    return tiles::ROCKS;
+}
+
+entt::entity load_movingai_map(entt::registry& registry, random_state& rng, const std::string& filename)
+{
+    std::istringstream in(read_movingai_file(filename));
+
+    vec2i dim = {-1, -1};
+    std::string word;
+
+    while(in >> word && word != "map")
+    {
+        if(word == "type")
+        {
+            std::string type;
+            in >> type;
+
+            if(type != "octile")
+                throw std::runtime_error("Unsupported map type " + type + " in " + filename);
+        }
+        else if(word == "height")
+            in >> dim.y();
+        else if(word == "width")
+            in >> dim.x();
+        else
+            throw std::runtime_error("Unexpected " + word + " in " + filename);
+    }
+
+    if(word != "map" || dim.x() <= 0 || dim.y() <= 0)
+        throw std::runtime_error("Bad map header in " + filename);
+
+    tilemap tmap;
+    tmap.create(dim);
+
+    for(int y = 0; y < dim.y(); y++)
+    {
+        std::string row;
+        in >> row;
+
+        if((int)row.size() != dim.x())
+            throw std::runtime_error("Row " + std::to_string(y) + " is the wrong width in " + filename);
+
+        for(int x = 0; x < dim.x(); x++)
+        {
+            char c = row[x];
+
+            if(c == '.' || c == 'G' || c == 'S')
+                continue;
+
+            sprite_handle handle = get_sprite_handle_of(rng, movingai_obstacle_tile(c));
+            handle.base_colour.w() = 1;
+
+            tilemap_position transform;
+            transform.pos = {x, y};
+
+            collidable coll;
+            coll.cost = -1;
+
+            entt::entity obstacle = create_scenery(registry, handle, transform, coll);
+
+            tmap.add(registry, obstacle, {x, y});
+        }
+    }
+
+    entt::entity res = registry.create();
+
+    registry.assign<tilemap>(res, tmap);
+
+    return res;
+}
+
+std::vector<movingai_scenario> load_movingai_scenarios(const std::string& filename)
+{
+    std::istringstream in(read_movingai_file(filename));
+
+    std::string line;
+    std::getline(in, line);
+
+    if(line.rfind("version", 0) != 0)
+        throw std::runtime_error("No version line in " + filename);
+
+    std::vector<movingai_scenario> ret;
+
+    while(std::getline(in, line))
+    {
+        if(line.size() == 0)
+            continue;
+
+        std::istringstream fields(line);
+
+        movingai_scenario scen;
+
+        ///map names never have spaces in them in the published sets, so whitespace splitting is fine
+        if(!(fields >> scen.bucket >> scen.map_name >> scen.map_dim.x() >> scen.map_dim.y()
+                    >> scen.start.x() >> scen.start.y() >> scen.fin.x() >> scen.fin.y() >> scen.optimal_length))
+            throw std::runtime_error("Bad scenario line " + std::to_string(ret.size() + 2) + " in " + filename);
+
+        ret.push_back(scen);
+    }
+
+    return ret;
+}
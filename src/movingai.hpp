@@ -0,0 +1,30 @@
+#ifndef MOVINGAI_HPP_INCLUDED
+#define MOVINGAI_HPP_INCLUDED
+
+#include <vector>
+#include <string>
+#include <vec/vec.hpp>
+#include <entt/entt.hpp>
+
+struct random_state;
+
+///one line of a MovingAI .scen file
+struct movingai_scenario
+{
+    int bucket = 0;
+    ///the map the scenario was made for, as written in the file
+    std::string map_name;
+    vec2i map_dim = {0, 0};
+    vec2i start = {0, 0};
+    vec2i fin = {0, 0};
+    ///octile distance with no corner cutting, which our pathfinder allows, so we can come in under it but never over
+    double optimal_length = 0;
+};
+
+///octile .map files from the MovingAI grid benchmarks. '.', 'G' and 'S' are open ground, everything else ('@', 'O', 'T', 'W') gets a blocking collidable
+///creates a tilemap entity with only the obstacles on it, throws on anything malformed
+entt::entity load_movingai_map(entt::registry& registry, random_state& rng, const std::string& filename);
+
+std::vector<movingai_scenario> load_movingai_scenarios(const std::string& filename);
+
+#endif // MOVINGAI_HPP_INCLUDED
@@ -0,0 +1,241 @@
+#include "nearest_cell.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <queue>
+
+static const vec2i ring[8] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+
+void nearest_cell_map::transform()
+{
+    int size = dim.x() * dim.y();
+
+    distance.assign(size, INT_MAX);
+    nearest.assign(size, -1);
+
+    for(int idx = 0; idx < size; idx++)
+    {
+        if(!valid[idx])
+            continue;
+
+        distance[idx] = 0;
+        nearest[idx] = idx;
+    }
+
+    auto relax = [&](int idx, int x, int y)
+    {
+        if(x < 0 || y < 0 || x >= dim.x() || y >= dim.y())
+            return;
+
+        int other = y * dim.x() + x;
+
+        if(distance[other] == INT_MAX || distance[other] + 1 >= distance[idx])
+            return;
+
+        distance[idx] = distance[other] + 1;
+        nearest[idx] = nearest[other];
+    };
+
+    ///every tile's nearest seed is either its own nearest or one of its neighbours', so two sweeps over the half neighbourhoods are exact for chessboard distance
+    for(int y = 0; y < dim.y(); y++)
+    {
+        for(int x = 0; x < dim.x(); x++)
+        {
+            int idx = y * dim.x() + x;
+
+            relax(idx, x - 1, y);
+            relax(idx, x - 1, y - 1);
+            relax(idx, x, y - 1);
+            relax(idx, x + 1, y - 1);
+        }
+    }
+
+    for(int y = dim.y() - 1; y >= 0; y--)
+    {
+        for(int x = dim.x() - 1; x >= 0; x--)
+        {
+            int idx = y * dim.x() + x;
+
+            relax(idx, x + 1, y);
+            relax(idx, x + 1, y + 1);
+            relax(idx, x, y + 1);
+            relax(idx, x - 1, y + 1);
+        }
+    }
+}
+
+bool nearest_cell_map::is_valid(vec2i pos) const
+{
+    if(pos.x() < 0 || pos.y() < 0 || pos.x() >= dim.x() || pos.y() >= dim.y())
+        return false;
+
+    return valid[pos.y() * dim.x() + pos.x()];
+}
+
+void nearest_cell_map::set_valid(vec2i pos, bool is_valid)
+{
+    if(pos.x() < 0 || pos.y() < 0 || pos.x() >= dim.x() || pos.y() >= dim.y())
+        return;
+
+    int idx = pos.y() * dim.x() + pos.x();
+
+    if((bool)valid[idx] == is_valid)
+        return;
+
+    if(is_valid)
+        add_seed(idx);
+    else
+        remove_seed(idx);
+}
+
+///floods outwards for as long as the new seed is closer than whatever tiles had before
+void nearest_cell_map::add_seed(int idx)
+{
+    valid[idx] = 1;
+    distance[idx] = 0;
+    nearest[idx] = idx;
+
+    std::vector<int> next = {idx};
+
+    for(int i = 0; i < (int)next.size(); i++)
+    {
+        int current = next[i];
+        int x = current % dim.x();
+        int y = current / dim.x();
+
+        for(const vec2i& offset : ring)
+        {
+            int ox = x + offset.x();
+            int oy = y + offset.y();
+
+            if(ox < 0 || oy < 0 || ox >= dim.x() || oy >= dim.y())
+                continue;
+
+            int other = oy * dim.x() + ox;
+
+            if(distance[current] + 1 >= distance[other])
+                continue;
+
+            distance[other] = distance[current] + 1;
+            nearest[other] = idx;
+            next.push_back(other);
+        }
+    }
+}
+
+///only the tiles that were pointing at this seed need fixing. They get refilled from whatever's bordering them
+void nearest_cell_map::remove_seed(int idx)
+{
+    valid[idx] = 0;
+
+    std::vector<int> region = {idx};
+
+    nearest[idx] = -1;
+    distance[idx] = INT_MAX;
+
+    for(int i = 0; i < (int)region.size(); i++)
+    {
+        int current = region[i];
+        int x = current % dim.x();
+        int y = current / dim.x();
+
+        for(const vec2i& offset : ring)
+        {
+            int ox = x + offset.x();
+            int oy = y + offset.y();
+
+            if(ox < 0 || oy < 0 || ox >= dim.x() || oy >= dim.y())
+                continue;
+
+            int other = oy * dim.x() + ox;
+
+            if(nearest[other] != idx)
+                continue;
+
+            nearest[other] = -1;
+            distance[other] = INT_MAX;
+            region.push_back(other);
+        }
+    }
+
+    using entry = std::pair<int, int>;
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry>> open;
+
+    ///anything outside the region is still exact, so it can seed the refill
+    for(int current : region)
+    {
+        int x = current % dim.x();
+        int y = current / dim.x();
+
+        for(const vec2i& offset : ring)
+        {
+            int ox = x + offset.x();
+            int oy = y + offset.y();
+
+            if(ox < 0 || oy < 0 || ox >= dim.x() || oy >= dim.y())
+                continue;
+
+            int other = oy * dim.x() + ox;
+
+            if(distance[other] == INT_MAX || distance[other] + 1 >= distance[current])
+                continue;
+
+            distance[current] = distance[other] + 1;
+            nearest[current] = nearest[other];
+        }
+
+        if(distance[current] != INT_MAX)
+            open.push({distance[current], current});
+    }
+
+    while(open.size() > 0)
+    {
+        auto [d, current] = open.top();
+        open.pop();
+
+        if(d > distance[current])
+            continue;
+
+        int x = current % dim.x();
+        int y = current / dim.x();
+
+        for(const vec2i& offset : ring)
+        {
+            int ox = x + offset.x();
+            int oy = y + offset.y();
+
+            if(ox < 0 || oy < 0 || ox >= dim.x() || oy >= dim.y())
+                continue;
+
+            int other = oy * dim.x() + ox;
+
+            if(d + 1 >= distance[other])
+                continue;
+
+            distance[other] = d + 1;
+            nearest[other] = nearest[current];
+            open.push({d + 1, other});
+        }
+    }
+}
+
+std::optional<vec2i> nearest_cell_map::find(vec2i pos, int max_distance) const
+{
+    if(dim.x() <= 0 || dim.y() <= 0)
+        return std::nullopt;
+
+    ///off the map gets pulled onto the edge first
+    vec2i clamped = {std::clamp(pos.x(), 0, dim.x() - 1), std::clamp(pos.y(), 0, dim.y() - 1)};
+
+    int found = nearest[clamped.y() * dim.x() + clamped.x()];
+
+    if(found == -1)
+        return std::nullopt;
+
+    vec2i ret = {found % dim.x(), found / dim.x()};
+
+    if(std::max(abs(ret.x() - pos.x()), abs(ret.y() - pos.y())) > max_distance)
+        return std::nullopt;
+
+    return ret;
+}
@@ -0,0 +1,52 @@
+#ifndef NEAREST_CELL_HPP_INCLUDED
+#define NEAREST_CELL_HPP_INCLUDED
+
+#include <vector>
+#include <optional>
+#include <stdint.h>
+#include <vec/vec.hpp>
+
+///for every tile, the nearest tile that satisfies some mask, by chessboard distance (the same rings square_search used to walk)
+///built with a two pass distance transform that carries the nearest seed along with the distance, so lookups are O(1)
+///tiles can be switched on and off afterwards, which only touches the area around them
+struct nearest_cell_map
+{
+    vec2i dim = {0, 0};
+
+    std::vector<uint8_t> valid;
+    ///chessboard distance to the nearest valid tile, INT_MAX if there are none
+    std::vector<int> distance;
+    ///index of that tile, -1 if there are none
+    std::vector<int> nearest;
+
+    ///is_valid(vec2i) is called once for every tile
+    template<typename T>
+    void build(vec2i _dim, const T& is_valid)
+    {
+        dim = _dim;
+        valid.assign(dim.x() * dim.y(), 0);
+
+        for(int y = 0; y < dim.y(); y++)
+        {
+            for(int x = 0; x < dim.x(); x++)
+            {
+                valid[y * dim.x() + x] = is_valid(vec2i{x, y});
+            }
+        }
+
+        transform();
+    }
+
+    bool is_valid(vec2i pos) const;
+    void set_valid(vec2i pos, bool is_valid);
+
+    ///nearest valid tile to pos, if there's one within max_distance. pos can be off the map
+    std::optional<vec2i> find(vec2i pos, int max_distance) const;
+
+private:
+    void transform();
+    void add_seed(int idx);
+    void remove_seed(int idx);
+};
+
+#endif // NEAREST_CELL_HPP_INCLUDED
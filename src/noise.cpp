@@ -0,0 +1,338 @@
+#include "noise.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include "random.hpp"
+
+///the avx2 and scalar paths have to round identically, a fused multiply-add in one and not the other would shift the coastline
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NOISE_AVX2
+#define NOISE_AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(__AVX2__)
+#define NOISE_AVX2
+#define NOISE_AVX2_TARGET
+#endif
+
+#ifdef NOISE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    ///which is the index of the grid, so the four grids come from separate stretches of the same stream
+    std::vector<float> generate_noise(const counter_rng& rng, vec2i dim, int which)
+    {
+        std::vector<float> ret;
+        ret.resize(dim.x() * dim.y());
+
+        rng.fill_uniform(ret.data(), ret.size(), (uint64_t)which * ret.size(), 0, 1);
+
+        return ret;
+    }
+
+    bool is_power_of_two(int x)
+    {
+        return x > 0 && (x & (x - 1)) == 0;
+    }
+
+    int log2_of(int x)
+    {
+        int ret = 0;
+
+        while((1 << ret) < x)
+            ret++;
+
+        return ret;
+    }
+
+    struct noise_grid
+    {
+        const float* data = nullptr;
+        int mask_x = 0;
+        int mask_y = 0;
+        ///log2 of the width, so y * width is a shift
+        int shift = 0;
+    };
+
+    ///everything the kernel needs, worked out once per batch so both paths use exactly the same constants
+    struct noise_params
+    {
+        noise_grid n1, n2, n3, n4;
+
+        float sample_freq = 0.005f;
+        float centre_x = 0;
+        float centre_y = 0;
+        float half_width = 0;
+        float half_land = 0;
+        float half_water = 0;
+    };
+
+    noise_params get_params(const noise_data& noise)
+    {
+        noise_params ret;
+
+        auto grid = [&](const std::vector<float>& data)
+        {
+            noise_grid g;
+            g.data = data.data();
+            g.mask_x = noise.dim.x() - 1;
+            g.mask_y = noise.dim.y() - 1;
+            g.shift = log2_of(noise.dim.x());
+            return g;
+        };
+
+        ret.n1 = grid(noise.noise_1);
+        ret.n2 = grid(noise.noise_2);
+        ret.n3 = grid(noise.noise_3);
+        ret.n4 = grid(noise.noise_4);
+
+        float width = noise.extent.x();
+        float water_width = width * 0.8f;
+        float land_width = width - water_width;
+
+        ret.centre_x = noise.extent.x() / 2;
+        ret.centre_y = noise.extent.y() / 2;
+        ret.half_width = width / 2;
+        ret.half_land = land_width / 2;
+        ret.half_water = water_width / 2;
+
+        return ret;
+    }
+
+    float lerp(float a, float b, float t)
+    {
+        return a + (b - a) * t;
+    }
+
+    float bilinear(const noise_grid& g, float x, float y)
+    {
+        float fx = std::floor(x);
+        float fy = std::floor(y);
+
+        float xfrac = x - fx;
+        float yfrac = y - fy;
+
+        int x0 = (int)fx & g.mask_x;
+        int y0 = (int)fy & g.mask_y;
+        int x1 = (x0 + 1) & g.mask_x;
+        int y1 = (y0 + 1) & g.mask_y;
+
+        float tl = g.data[(y0 << g.shift) | x0];
+        float tr = g.data[(y0 << g.shift) | x1];
+        float bl = g.data[(y1 << g.shift) | x0];
+        float br = g.data[(y1 << g.shift) | x1];
+
+        return lerp(lerp(tl, tr, xfrac), lerp(bl, br, xfrac), yfrac);
+    }
+
+    float density_at(const noise_params& p, float x, float y)
+    {
+        float sx = x * p.sample_freq;
+        float sy = y * p.sample_freq;
+
+        float warp_x = bilinear(p.n2, sx, sy);
+        float warp_y = bilinear(p.n3, sx, sy);
+        float warp2_x = bilinear(p.n2, sx * 10, sy * 10);
+        float warp2_y = bilinear(p.n3, sx * 10, sy * 10);
+
+        float wx = x + warp_x * 40 + warp2_x * 20;
+        float wy = y + warp_y * 40 + warp2_y * 20;
+
+        float density = bilinear(p.n1, wx, wy);
+        density += bilinear(p.n1, wx * 0.5f, wy * 0.5f) * 2;
+        density += bilinear(p.n1, wx * 0.25f, wy * 0.25f) * 4;
+        density += bilinear(p.n1, wx * 0.125f, wy * 0.125f) * 8;
+
+        float final_density = density / (8 + 4 + 2 + 1);
+
+        float dx = x - p.centre_x;
+        float dy = y - p.centre_y;
+
+        float distance_from_centre = std::sqrt(dx * dx + dy * dy);
+        distance_from_centre = std::min(std::max(distance_from_centre, 0.f), p.half_width);
+
+        if(distance_from_centre < p.half_land)
+            return final_density;
+
+        ///out in the sea, eat into the land so the coast breaks up
+        float water_frac = (distance_from_centre - p.half_land) / p.half_water;
+
+        float subtractive_density = bilinear(p.n4, wx * 0.03125f, wy * 0.03125f);
+
+        float low_val = final_density - subtractive_density;
+        low_val = std::min(std::max(low_val, 0.f), 1.f);
+
+        return lerp(final_density, low_val, water_frac);
+    }
+
+    #ifdef NOISE_AVX2
+    NOISE_AVX2_TARGET
+    __m256 lerp8(__m256 a, __m256 b, __m256 t)
+    {
+        return _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), t));
+    }
+
+    NOISE_AVX2_TARGET
+    __m256 bilinear8(const noise_grid& g, __m256 x, __m256 y)
+    {
+        __m256 fx = _mm256_floor_ps(x);
+        __m256 fy = _mm256_floor_ps(y);
+
+        __m256 xfrac = _mm256_sub_ps(x, fx);
+        __m256 yfrac = _mm256_sub_ps(y, fy);
+
+        __m256i one = _mm256_set1_epi32(1);
+        __m256i mask_x = _mm256_set1_epi32(g.mask_x);
+        __m256i mask_y = _mm256_set1_epi32(g.mask_y);
+        __m128i shift = _mm_cvtsi32_si128(g.shift);
+
+        __m256i x0 = _mm256_and_si256(_mm256_cvttps_epi32(fx), mask_x);
+        __m256i y0 = _mm256_and_si256(_mm256_cvttps_epi32(fy), mask_y);
+        __m256i x1 = _mm256_and_si256(_mm256_add_epi32(x0, one), mask_x);
+        __m256i y1 = _mm256_and_si256(_mm256_add_epi32(y0, one), mask_y);
+
+        __m256i row0 = _mm256_sll_epi32(y0, shift);
+        __m256i row1 = _mm256_sll_epi32(y1, shift);
+
+        __m256 tl = _mm256_i32gather_ps(g.data, _mm256_or_si256(row0, x0), 4);
+        __m256 tr = _mm256_i32gather_ps(g.data, _mm256_or_si256(row0, x1), 4);
+        __m256 bl = _mm256_i32gather_ps(g.data, _mm256_or_si256(row1, x0), 4);
+        __m256 br = _mm256_i32gather_ps(g.data, _mm256_or_si256(row1, x1), 4);
+
+        return lerp8(lerp8(tl, tr, xfrac), lerp8(bl, br, xfrac), yfrac);
+    }
+
+    ///density_at, eight at a time
+    NOISE_AVX2_TARGET
+    void density_at8(const noise_params& p, const float* xs, const float* ys, float* out)
+    {
+        __m256 x = _mm256_loadu_ps(xs);
+        __m256 y = _mm256_loadu_ps(ys);
+
+        __m256 freq = _mm256_set1_ps(p.sample_freq);
+        __m256 ten = _mm256_set1_ps(10);
+
+        __m256 sx = _mm256_mul_ps(x, freq);
+        __m256 sy = _mm256_mul_ps(y, freq);
+        __m256 sx10 = _mm256_mul_ps(sx, ten);
+        __m256 sy10 = _mm256_mul_ps(sy, ten);
+
+        __m256 warp_x = bilinear8(p.n2, sx, sy);
+        __m256 warp_y = bilinear8(p.n3, sx, sy);
+        __m256 warp2_x = bilinear8(p.n2, sx10, sy10);
+        __m256 warp2_y = bilinear8(p.n3, sx10, sy10);
+
+        __m256 forty = _mm256_set1_ps(40);
+        __m256 twenty = _mm256_set1_ps(20);
+
+        __m256 wx = _mm256_add_ps(_mm256_add_ps(x, _mm256_mul_ps(warp_x, forty)), _mm256_mul_ps(warp2_x, twenty));
+        __m256 wy = _mm256_add_ps(_mm256_add_ps(y, _mm256_mul_ps(warp_y, forty)), _mm256_mul_ps(warp2_y, twenty));
+
+        __m256 density = bilinear8(p.n1, wx, wy);
+
+        float scales[3] = {0.5f, 0.25f, 0.125f};
+        float weights[3] = {2, 4, 8};
+
+        for(int i = 0; i < 3; i++)
+        {
+            __m256 scale = _mm256_set1_ps(scales[i]);
+            __m256 octave = bilinear8(p.n1, _mm256_mul_ps(wx, scale), _mm256_mul_ps(wy, scale));
+
+            density = _mm256_add_ps(density, _mm256_mul_ps(octave, _mm256_set1_ps(weights[i])));
+        }
+
+        __m256 final_density = _mm256_div_ps(density, _mm256_set1_ps(8 + 4 + 2 + 1));
+
+        __m256 dx = _mm256_sub_ps(x, _mm256_set1_ps(p.centre_x));
+        __m256 dy = _mm256_sub_ps(y, _mm256_set1_ps(p.centre_y));
+
+        __m256 distance_from_centre = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+        distance_from_centre = _mm256_min_ps(_mm256_max_ps(distance_from_centre, _mm256_setzero_ps()), _mm256_set1_ps(p.half_width));
+
+        __m256 half_land = _mm256_set1_ps(p.half_land);
+        __m256 in_sea = _mm256_cmp_ps(distance_from_centre, half_land, _CMP_GE_OQ);
+
+        ///all on land, skip the gathers for the coast
+        if(_mm256_movemask_ps(in_sea) == 0)
+        {
+            _mm256_storeu_ps(out, final_density);
+            return;
+        }
+
+        __m256 water_frac = _mm256_div_ps(_mm256_sub_ps(distance_from_centre, half_land), _mm256_set1_ps(p.half_water));
+
+        __m256 sub_scale = _mm256_set1_ps(0.03125f);
+        __m256 subtractive_density = bilinear8(p.n4, _mm256_mul_ps(wx, sub_scale), _mm256_mul_ps(wy, sub_scale));
+
+        __m256 low_val = _mm256_sub_ps(final_density, subtractive_density);
+        low_val = _mm256_min_ps(_mm256_max_ps(low_val, _mm256_setzero_ps()), _mm256_set1_ps(1));
+
+        __m256 coast = lerp8(final_density, low_val, water_frac);
+
+        _mm256_storeu_ps(out, _mm256_blendv_ps(final_density, coast, in_sea));
+    }
+
+    bool has_avx2()
+    {
+        #if defined(__GNUC__)
+        static bool ret = __builtin_cpu_supports("avx2");
+        return ret;
+        #else
+        return true;
+        #endif
+    }
+    #endif // NOISE_AVX2
+}
+
+noise_data::noise_data(const random_state& rng, vec2i _dim, vec2f _extent) : dim(_dim), extent(_extent)
+{
+    if(!is_power_of_two(dim.x()) || !is_power_of_two(dim.y()))
+        throw std::runtime_error("Noise dimensions must be powers of two");
+
+    counter_rng stream = rng.stream(rng_stream::TERRAIN_NOISE);
+
+    noise_1 = generate_noise(stream, dim, 0);
+    noise_2 = generate_noise(stream, dim, 1);
+    noise_3 = generate_noise(stream, dim, 2);
+    noise_4 = generate_noise(stream, dim, 3);
+}
+
+float noise_data::sample(vec2f pos) const
+{
+    float x = pos.x();
+    float y = pos.y();
+    float ret = 0;
+
+    sample(&x, &y, &ret, 1);
+
+    return ret;
+}
+
+void noise_data::sample(const float* xs, const float* ys, float* out, int count) const
+{
+    noise_params p = get_params(*this);
+
+    int i = 0;
+
+    #ifdef NOISE_AVX2
+    if(has_avx2())
+    {
+        for(; i + 8 <= count; i += 8)
+        {
+            density_at8(p, xs + i, ys + i, out + i);
+        }
+    }
+    #endif // NOISE_AVX2
+
+    for(; i < count; i++)
+    {
+        out[i] = density_at(p, xs[i], ys[i]);
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef NOISE_HPP_INCLUDED
+#define NOISE_HPP_INCLUDED
+
+#include <vector>
+#include <vec/vec.hpp>
+
+struct random_state;
+
+///value noise for the overworld's land/water density, domain warped with four octaves and an island falloff
+///the noise grids wrap, and have to be a power of two on each side so wrapping is a bitmask
+struct noise_data
+{
+    std::vector<float> noise_1;
+    std::vector<float> noise_2;
+    std::vector<float> noise_3;
+    std::vector<float> noise_4;
+    vec2i dim;
+
+    ///positions get sampled over [0, extent), the island sits in the middle of that
+    vec2f extent;
+
+    noise_data(const random_state& rng, vec2i _dim, vec2f _extent);
+
+    float sample(vec2f pos) const;
+
+    ///count positions at once, xs/ys/out are all count long
+    ///uses avx2 when the cpu has it, otherwise scalar. Both give exactly the same answers, so the map doesn't depend on the machine
+    void sample(const float* xs, const float* ys, float* out, int count) const;
+};
+
+#endif // NOISE_HPP_INCLUDED
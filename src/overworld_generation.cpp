@@ -6,130 +6,17 @@
 #include "tilemap.hpp"
 #include "overworld_map.hpp"
 #include "overworld_building.hpp"
-
-std::vector<float> generate_noise(random_state& rng, vec2i dim)
-{
-    std::vector<float> ret;
-    ret.resize(dim.x() * dim.y());
-
-    for(auto& i : ret)
-    {
-        i = rand_det_s(rng.rng, 0, 1);
-    }
-
-    return ret;
-}
-
-float positive_fmod(float x, float y)
-{
-    float result = std::remainder(std::fabs(x), (y = std::fabs(y)));
-
-    if (std::signbit(result))
-    {
-        result += y;
-    }
-
-    return result;
-}
-
-float simple_sample(const std::vector<float>& data, vec2f pos, vec2i dim)
-{
-    vec2f tl = floor(pos);
-    vec2f br = ceil(pos);
-
-    float xfrac = (pos.x() - tl.x());
-    float yfrac = (pos.y() - tl.y());
-
-    tl.x() = positive_fmod(tl.x(), dim.x() - 1);
-    tl.y() = positive_fmod(tl.y(), dim.y() - 1);
-
-    br.x() = positive_fmod(br.x(), dim.x() - 1);
-    br.y() = positive_fmod(br.y(), dim.y() - 1);
-
-    float tl_val = data[((int)tl.y()) * dim.x() + (int)tl.x()];
-    float tr_val = data[((int)tl.y()) * dim.x() + (int)br.x()];
-    float bl_val = data[((int)br.y()) * dim.x() + (int)tl.x()];
-    float br_val = data[((int)br.y()) * dim.x() + (int)br.x()];
-
-    float y1 = mix(tl_val, tr_val, xfrac);
-    float y2 = mix(bl_val, br_val, xfrac);
-
-    return mix(y1, y2, yfrac);
-}
-
-struct noise_data
+#include "nearest_cell.hpp"
+#include "poisson_disk.hpp"
+#include "territory.hpp"
+#include "road_network.hpp"
+#include "parallel.hpp"
+#include "noise.hpp"
+#include <chrono>
+
+///what a tile looks like and what it costs to cross. Doesn't touch the registry, so lots of these can run at once
+terrain_tile describe_tile_from_density(random_state& rng, float fraction)
 {
-    std::vector<float> noise_1;
-    std::vector<float> noise_2;
-    std::vector<float> noise_3;
-    std::vector<float> noise_4;
-    vec2i dim;
-
-    noise_data(random_state& rng, vec2i _dim) : dim(_dim)
-    {
-        noise_1 = generate_noise(rng, dim);
-        noise_2 = generate_noise(rng, dim);
-        noise_3 = generate_noise(rng, dim);
-        noise_4 = generate_noise(rng, dim);
-    }
-
-    float sample(vec2f pos)
-    {
-        float sample_freq = 0.005;
-
-        vec2f warp = {simple_sample(noise_2, pos * sample_freq, dim), simple_sample(noise_3, pos * sample_freq, dim)};
-        vec2f warp2 = vec2f{simple_sample(noise_2, pos * sample_freq * 10, dim), simple_sample(noise_3, pos * sample_freq * 10, dim)};
-
-        vec2f wpos = pos + warp * 40 + warp2 * 20;
-
-        float density = 0;
-
-        density += simple_sample(noise_1, wpos, dim);
-        density += simple_sample(noise_1, wpos / 2.f, dim) * 2;
-        density += simple_sample(noise_1, wpos / 4.f, dim) * 4;
-        density += simple_sample(noise_1, wpos / 8.f, dim) * 8;
-
-        float width = dim.x();
-
-        float water_width = width * 0.8;
-        float land_width = width - water_width;
-
-        vec2f centre = vec2f{dim.x(), dim.y()}/2.f;
-
-        float distance_from_centre = (pos - centre).length();
-
-        distance_from_centre = clamp(distance_from_centre, 0.f, width/2);
-
-        float final_density = density / (8 + 4 + 2 + 1);
-
-        if(distance_from_centre >= land_width/2)
-        {
-            float water_frac = (distance_from_centre - (land_width/2)) / (water_width/2);
-
-            float subtractive_density = simple_sample(noise_4, wpos/32.f, dim);
-
-            float low_val = final_density - subtractive_density;
-
-            low_val = clamp(low_val, 0.f, 1.f);
-
-            //return low_val;
-
-            return mix(final_density, low_val, water_frac);
-
-            //return mix(final_density, 0.f, (distance_from_centre - land_width/2) / (water_width/2));
-        }
-
-        return final_density;
-    }
-};
-
-entt::entity create_tile_from_density(entt::registry& registry, random_state& rng, noise_data& noise, vec2i pos, vec2i dim)
-{
-    vec2f fpos = {pos.x(), pos.y()};
-    fpos = fpos / vec2f{dim.x(), dim.y()};
-
-    float fraction = noise.sample(fpos * 100);
-
     sprite_handle han;
     collidable coll;
 
@@ -226,16 +113,49 @@ entt::entity create_tile_from_density(entt::registry& registry, random_state& rn
 
     #endif // HACKY_BLENDING_FIX
 
+    return {han, coll};
+}
+
+noise_data create_overworld_noise(const random_state& rng)
+{
+    return noise_data(rng, {128, 128}, {100, 100});
+}
+
+void generate_terrain_row(const random_state& rng, const noise_data& noise, vec2i world_dim, vec2i start, int count, terrain_tile* out)
+{
+    ///the whole row's density in one batch
+    std::vector<float> xs(count);
+    std::vector<float> ys(count, (float)start.y() / world_dim.y() * 100);
+    std::vector<float> density(count);
+
+    for(int i = 0; i < count; i++)
+    {
+        xs[i] = (float)(start.x() + i) / world_dim.x() * 100;
+    }
+
+    noise.sample(xs.data(), ys.data(), density.data(), count);
+
+    for(int i = 0; i < count; i++)
+    {
+        ///each tile gets its own generator rather than sharing rng, so rows can be split across threads and still come out bit identical
+        random_state tile_rng = rng.fork(rng_stream::TERRAIN_TILES, (uint64_t)start.y() * world_dim.x() + start.x() + i);
+
+        out[i] = describe_tile_from_density(tile_rng, density[i]);
+    }
+}
+
+entt::entity create_terrain_tile(entt::registry& registry, const terrain_tile& tile, vec2i pos)
+{
     render_descriptor desc;
     desc.pos = vec2f{pos.x(), pos.y()} * TILE_PIX + vec2f{TILE_PIX / 2, TILE_PIX / 2};
     desc.depress_on_hover = true;
 
     entt::entity base = registry.create();
 
-    registry.assign<sprite_handle>(base, han);
+    registry.assign<sprite_handle>(base, tile.han);
     registry.assign<render_descriptor>(base, desc);
     registry.assign<overworld_tag>(base, overworld_tag());
-    registry.assign<collidable>(base, coll);
+    registry.assign<collidable>(base, tile.coll);
 
     return base;
 }
@@ -246,51 +166,26 @@ bool is_valid_castle_spawn(entt::registry& registry, tilemap& tmap, vec2f fpos)
 
     vec2i ipos = {fpos.x(), fpos.y()};
 
-    if(ipos.x() < 0 || ipos.y() < 0 || ipos.x() >= tmap.dim.x() || ipos.y() >= tmap.dim.y())
+    if(!tmap.in_bounds(ipos))
         return false;
 
+    ///plain grass only
+    if(tmap.static_cost[ipos.y() * tmap.dim.x() + ipos.x()] != 1)
+        return false;
+
+    ///buildings don't block movement, so the cost above doesn't see them
     for(entt::entity en : tmap.all_entities[ipos.y() * tmap.dim.x() + ipos.x()])
     {
-        if(!registry.has<collidable>(en))
-            continue;
-
-        collidable& coll = registry.get<collidable>(en);
-
-        if(!(coll.cost == 1))
+        if(registry.has<building_tag>(en))
             return false;
     }
 
-    return true;
-    //return a_star(registry, tmap, tmap.dim/2, vec2i{fpos.x(), fpos.y()}).has_value();
-
-    //return true;
-}
-
-template<typename T>
-std::optional<vec2i> square_search(entt::registry& registry, tilemap& tmap, vec2i start_pos, int max_distance, const T& is_valid)
-{
-    int bound = 0;
-    int inner_bound = 0;
-
-    while(bound <= max_distance)
-    {
-        for(int y=-bound; y<=bound; y++)
-        {
-            for(int x=-bound; x <= bound; x++)
-            {
-                if(std::max(abs(x), abs(y)) < inner_bound)
-                    continue;
+    ///and on the main landmass, not some island nobody can march to
+    tmap.reachability.update(tmap);
 
-                if(is_valid(registry, tmap, vec2f{x + start_pos.x(), y + start_pos.y()}))
-                    return vec2i{x, y} + start_pos;
-            }
-        }
-
-        bound++;
-        inner_bound++;
-    }
+    return tmap.reachability.component_of(ipos) == tmap.reachability.largest_component();
 
-    return std::nullopt;
+    //return true;
 }
 
 entt::entity create_overworld(entt::registry& registry, random_state& rng, vec2i dim)
@@ -303,18 +198,32 @@ entt::entity create_overworld(entt::registry& registry, random_state& rng, vec2i
     vec2i centre = dim/2;
     vec2f fcentre = vec2f{dim.x(), dim.y()}/2.f;
 
-    noise_data noise(rng, {100, 100});
+    noise_data noise = create_overworld_noise(rng);
+
+    std::vector<terrain_tile> terrain(dim.x() * dim.y());
 
+    parallel_for(dim.y(), -1, [&](int y)
+    {
+        generate_terrain_row(rng, noise, dim, {0, y}, dim.x(), &terrain[y * dim.x()]);
+    });
+
+    ///the registry isn't thread safe, so the entities get made afterwards in tile order
     for (int y = 0; y < dim.y(); y++)
     {
         for (int x = 0; x < dim.x(); x++)
         {
-            auto base = create_tile_from_density(registry, rng, noise, {x, y}, dim);
+            auto base = create_terrain_tile(registry, terrain[y * dim.x() + x], {x, y});
 
-            tmap.add(base, {x, y});
+            tmap.add(registry, base, {x, y});
         }
     }
 
+    ///castles and towns all want plain grass on the main landmass, so work out where that is once and keep it up to date as things get built
+    nearest_cell_map castle_spots;
+    castle_spots.build(dim, [&](vec2i pos){return is_valid_castle_spawn(registry, tmap, {pos.x(), pos.y()});});
+
+    territory_map territory;
+
     int factions = 6;
 
     float faction_radius = (dim.x() * 0.3) * 5.f / factions;
@@ -369,11 +278,13 @@ entt::entity create_overworld(entt::registry& registry, random_state& rng, vec2i
                 force += (move_frac * diff).norm() * 0.1;
             }
 
-            if(!is_valid_castle_spawn(registry, tmap, current_pos[fid] + force))
+            vec2f next_pos = round(current_pos[fid] + force);
+
+            if(!castle_spots.is_valid({next_pos.x(), next_pos.y()}))
             {
                 vec2i ipos = {current_pos[fid].x() + force.x(), current_pos[fid].y() + force.y()};
 
-                auto compromise = square_search(registry, tmap, ipos, 2, is_valid_castle_spawn);
+                auto compromise = castle_spots.find(ipos, 2);
 
                 if(!compromise.has_value())
                     continue;
@@ -405,7 +316,7 @@ entt::entity create_overworld(entt::registry& registry, random_state& rng, vec2i
 
         printf("SFPos %f %f\n", my_pos.x(), my_pos.y());
 
-        auto next_pos = square_search(registry, tmap, {my_pos.x(), my_pos.y()}, 40, is_valid_castle_spawn);
+        auto next_pos = castle_spots.find({my_pos.x(), my_pos.y()}, 40);
 
         if(!next_pos.has_value())
             throw std::runtime_error("Could not place root castle ");
@@ -442,7 +353,8 @@ entt::entity create_overworld(entt::registry& registry, random_state& rng, vec2i
 
         registry.assign<team>(en, t);
 
-        tmap.add(en, trans.pos);
+        tmap.add(registry, en, trans.pos);
+        castle_spots.set_valid(trans.pos, false);
 
         printf("End %i %i\n", trans.pos.x(), trans.pos.y());
 
@@ -499,7 +411,7 @@ entt::entity create_overworld(entt::registry& registry, random_state& rng, vec2i
 
                 vec2f real_pos = relative_vector + vec2f{centre.x(), centre.y()};
 
-                auto adjusted = square_search(registry, tmap, {real_pos.x(), real_pos.y()}, 40, is_valid_castle_spawn);
+                auto adjusted = castle_spots.find({real_pos.x(), real_pos.y()}, 40);
 
                 if(!adjusted.has_value())
                     throw std::runtime_error("Could not situate secondary caste");
@@ -522,7 +434,8 @@ entt::entity create_overworld(entt::registry& registry, random_state& rng, vec2i
 
                     registry.assign<team>(en, t);
 
-                    tmap.add(en, adjusted.value());
+                    tmap.add(registry, en, adjusted.value());
+                    castle_spots.set_valid(adjusted.value(), false);
                 }
             }
         }
@@ -530,61 +443,33 @@ entt::entity create_overworld(entt::registry& registry, random_state& rng, vec2i
 
     // Generate towns
     {
-        int towns = 1000;
-
-        std::vector<vec2f> spawnable_towns;
+        ///towns have to keep further from each other than from castles. Spacing is per team, so a faction's heartland can be made denser or sparser
+        float castle_spacing = faction_radius / 20;
+        std::vector<float> town_spacing(factions, faction_radius / 5);
 
-        for(int i=0; i < towns; i++)
-        {
-            float min_dist = faction_radius / 10;
+        float min_spacing = std::min(castle_spacing, *std::min_element(town_spacing.begin(), town_spacing.end()));
 
-            vec2f diff = {rand_det_s(rng.rng, -faction_radius, faction_radius), rand_det_s(rng.rng, -faction_radius, faction_radius)};
-            vec2f potential_spot = round(diff + fcentre);
+        poisson_disk_sampler sampler(fcentre - vec2f{faction_radius, faction_radius}, fcentre + vec2f{faction_radius, faction_radius}, min_spacing);
 
-            if(!is_valid_castle_spawn(registry, tmap, potential_spot))
-                continue;
+        for(auto& pos : all_positions)
+            sampler.add(pos, castle_spacing);
 
-            bool is_valid = true;
+        ///every tile goes to whichever castle can march there cheapest
+        std::vector<vec2i> castle_tiles;
 
-            for(auto& i : all_positions)
-            {
-                float len = (potential_spot - i).length();
+        for(auto& pos : all_positions)
+            castle_tiles.push_back({(int)pos.x(), (int)pos.y()});
 
-                if(len < faction_radius / 20)
-                {
-                    is_valid = false;
-                    break;
-                }
-            }
+        territory.build(tmap, castle_tiles, all_teams);
 
-            for(auto& i : spawnable_towns)
-            {
-                float len = (potential_spot - i).length();
+        auto is_valid_town = [&](vec2f pos){return castle_spots.is_valid({pos.x(), pos.y()});};
+        auto spacing_at = [&](vec2f pos){return town_spacing[std::max(territory.team_at({pos.x(), pos.y()}), 0)];};
 
-                if(len < faction_radius / 5)
-                {
-                    is_valid = false;
-                    break;
-                }
-            }
-
-            if(!is_valid)
-                continue;
-
-            /*world_transform trans;
-            trans.position = vec2f{potential_spot.x(), potential_spot.y()} * TILE_PIX + vec2f{TILE_PIX/2, TILE_PIX/2};
-
-            sprite_handle handle = get_sprite_handle_of(rng, tiles::HOUSE_1);
-
-            //handle.base_colour *= team::colours.at(idx);
-
-            entt::entity en = create_overworld_building(registry, handle, trans);
-
-            tmap.add(en, {potential_spot.x(), potential_spot.y()});*/
-
-            //all_positions.push_back(potential_spot);
+        std::vector<vec2f> spawnable_towns;
 
-            spawnable_towns.push_back(potential_spot);
+        for(int idx : sampler.sample(rng, 8, is_valid_town, spacing_at))
+        {
+            spawnable_towns.push_back(sampler.points[idx]);
         }
 
         std::shuffle(spawnable_towns.begin(), spawnable_towns.end(), rng.rng);
@@ -592,23 +477,17 @@ entt::entity create_overworld(entt::registry& registry, random_state& rng, vec2i
         if(spawnable_towns.size() > 100)
             spawnable_towns.resize(100);
 
+        std::vector<int> town_teams;
+
         for(auto& potential_spot : spawnable_towns)
         {
-            float min_dist = FLT_MAX;
-            int min_team = -1;
+            int fteam = territory.team_at({potential_spot.x(), potential_spot.y()});
 
-            for(int i=0; i < (int)all_positions.size(); i++)
-            {
-                vec2f diff = (all_positions[i] - potential_spot).length();
+            town_teams.push_back(fteam);
 
-                if(diff.length() < min_dist)
-                {
-                    min_dist = diff.length();
-                    min_team = all_teams[i];
-                }
-            }
-
-            int fteam = min_team;
+            ///somewhere no castle can march to
+            if(fteam == -1)
+                continue;
 
             tilemap_position trans;
             trans.pos = vec2i{ (int)potential_spot.x(), (int)potential_spot.y() };
@@ -624,12 +503,48 @@ entt::entity create_overworld(entt::registry& registry, random_state& rng, vec2i
 
             registry.assign<team>(en, t);
 
-            tmap.add(en, {potential_spot.x(), potential_spot.y()});
+            tmap.add(registry, en, {potential_spot.x(), potential_spot.y()});
+            castle_spots.set_valid(trans.pos, false);
+        }
+
+        ///towns hold ground for their team too, once they've all been given one
+        for(int i = 0; i < (int)spawnable_towns.size(); i++)
+        {
+            if(town_teams[i] != -1)
+                territory.add_source(tmap, {spawnable_towns[i].x(), spawnable_towns[i].y()}, town_teams[i]);
         }
+
+        //castles and towns are where armies are going to and from, so they make good landmarks for long routes
+        std::vector<vec2i> settlements;
+
+        for(auto& pos : all_positions)
+            settlements.push_back({(int)pos.x(), (int)pos.y()});
+
+        for(auto& pos : spawnable_towns)
+            settlements.push_back({(int)pos.x(), (int)pos.y()});
+
+        tmap.landmarks.set_candidates(settlements);
+    }
+
+    // Generate roads
+    {
+        auto road_start = std::chrono::steady_clock::now();
+
+        ///only settlements that actually got built, a town nobody could reach never went down
+        std::vector<vec2i> settlements = territory.sources;
+
+        std::vector<vec2i> road = plan_road_network(tmap, settlements);
+
+        build_roads(registry, tmap, road);
+
+        double road_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - road_start).count();
+
+        printf("Roads: %i tiles joining %i settlements in %fms\n", (int)road.size(), (int)settlements.size(), road_ms);
     }
 
     registry.assign<tilemap>(res, tmap);
     registry.assign<overworld_tag>(res, overworld_tag());
+    registry.assign<territory_map>(res, territory);
 
     return res;
 }
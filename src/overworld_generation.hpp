@@ -3,8 +3,25 @@
 
 #include <entt/entt.hpp>
 #include <vec/vec.hpp>
+#include "entity_common.hpp"
+#include "sprite_renderer.hpp"
 
 struct random_state;
+struct noise_data;
+
+///what one overworld tile looks like and what it costs to cross
+struct terrain_tile
+{
+    sprite_handle han;
+    collidable coll;
+};
+
+noise_data create_overworld_noise(const random_state& rng);
+
+///terrain for count tiles along a row of a world_dim sized overworld, starting at start
+///only depends on rng's seed and where each tile is, so any thread can generate any part of the map in any order
+void generate_terrain_row(const random_state& rng, const noise_data& noise, vec2i world_dim, vec2i start, int count, terrain_tile* out);
+entt::entity create_terrain_tile(entt::registry& registry, const terrain_tile& tile, vec2i pos);
 
 entt::entity create_overworld(entt::registry& registry, random_state& rng, vec2i dim);
 
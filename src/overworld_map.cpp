@@ -1,6 +1,10 @@
 #include "overworld_map.hpp"
+#include <imgui/imgui.h>
+#include <toolkit/render_window.hpp>
 #include "entity_common.hpp"
 #include "overworld_building.hpp"
+#include "pathfinding.hpp"
+#include "camera.hpp"
 
 entt::entity create_overworld_unit(entt::registry& registry, sprite_handle handle, tilemap_position transform)
 {
@@ -62,8 +66,8 @@ void debug_overworld(entt::registry& registry, entt::entity en, random_state& rn
     entt::entity army1 = create_dummy_army_at(registry, rng, {half.x(), half.y() - 1}, 0);
     entt::entity army2 = create_dummy_army_at(registry, rng, {half.x()+1, half.y() - 1}, 1);
 
-    tmap.add(army1, {half.x(), half.y() - 1});
-    tmap.add(army2, {half.x()+1, half.y() - 1});
+    tmap.add(registry, army1, {half.x(), half.y() - 1});
+    tmap.add(registry, army2, {half.x()+1, half.y() - 1});
 }
 
 entt::entity start_battle(entt::registry& registry, const std::vector<entt::entity>& armies)
@@ -72,3 +76,115 @@ entt::entity start_battle(entt::registry& registry, const std::vector<entt::enti
 
     return ret;
 }
+
+bool order_march(entt::registry& registry, tilemap& tmap, entt::entity army, vec2i destination)
+{
+    vec2i start = registry.get<tilemap_position>(army).pos;
+
+    if(!tmap.in_bounds(destination) || start == destination)
+        return false;
+
+    overworld_march march;
+    march.destination = destination;
+
+    vec2i diff = destination - start;
+
+    if(std::max(abs(diff.x()), abs(diff.y())) > hierarchical_march_distance)
+    {
+        march.route = get_hierarchical_path(tmap, start, destination);
+
+        if(!march.route.has_value())
+            return false;
+
+        ///the first leg gets refined on the first step
+        march.leg = {start};
+    }
+    else
+    {
+        auto found = a_star(tmap, start, destination, path_mode::ASTAR);
+
+        if(!found.has_value())
+            return false;
+
+        march.leg = std::move(found.value());
+    }
+
+    if(registry.has<overworld_march>(army))
+        registry.get<overworld_march>(army) = std::move(march);
+    else
+        registry.assign<overworld_march>(army, std::move(march));
+
+    return true;
+}
+
+///false once the army's got where it's going, or can't get any further
+static bool step_march(entt::registry& registry, tilemap& tmap, entt::entity army, overworld_march& march)
+{
+    tilemap_position& pos = registry.get<tilemap_position>(army);
+
+    if(march.leg_next >= (int)march.leg.size())
+    {
+        if(!march.route.has_value() || march.route.value().finished())
+            return false;
+
+        std::optional<std::vector<vec2i>> leg = march.route.value().refine_next(tmap);
+
+        ///the map changed under the route, so plan again from here
+        if(!leg.has_value())
+            return order_march(registry, tmap, army, march.destination);
+
+        march.leg = std::move(leg.value());
+        march.leg_next = 1;
+
+        if(march.leg_next >= (int)march.leg.size())
+            return true;
+    }
+
+    vec2i next_p = march.leg[march.leg_next];
+
+    if(tmap.path_cost[next_p.y() * tmap.dim.x() + next_p.x()] == -1)
+        return order_march(registry, tmap, army, march.destination);
+
+    registry.get<render_descriptor>(army).pos = camera::tile_to_world(vec2f{ next_p.x(), next_p.y() });
+    tmap.move(registry, army, pos.pos, next_p);
+    pos.pos = next_p;
+
+    march.leg_next++;
+
+    return true;
+}
+
+void update_overworld_armies(entt::registry& registry, tilemap& tmap, render_window& win, camera& cam, vec2f mpos, float delta_time)
+{
+    if(tmap.selected.has_value() && registry.valid(tmap.selected.value()) && registry.has<unit_group>(tmap.selected.value()) &&
+       ImGui::IsMouseClicked(1) && !ImGui::IsAnyWindowHovered())
+    {
+        vec2f mouse_tile = cam.screen_to_tile(win, mpos);
+
+        order_march(registry, tmap, tmap.selected.value(), vec2i{mouse_tile.x(), mouse_tile.y()} - tmap.origin);
+    }
+
+    std::vector<entt::entity> arrived;
+
+    auto view = registry.view<overworld_march, tilemap_position, render_descriptor>();
+
+    for(auto ent : view)
+    {
+        overworld_march& march = view.get<overworld_march>(ent);
+
+        march.time_left -= delta_time;
+
+        if(march.time_left > 0)
+            continue;
+
+        march.time_left = march.time_between_steps;
+
+        if(!step_march(registry, tmap, ent, march))
+            arrived.push_back(ent);
+    }
+
+    for(entt::entity en : arrived)
+    {
+        registry.remove<overworld_march>(en);
+    }
+}
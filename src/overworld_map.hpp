@@ -2,7 +2,36 @@
 #define OVERWORLD_MAP_HPP_INCLUDED
 
 #include <entt/entt.hpp>
+#include <optional>
 #include "tilemap.hpp"
+#include "path_hierarchy.hpp"
+
+struct render_window;
+struct camera;
+
+///an army walking somewhere on the overworld, a tile every time_between_steps
+///long marches keep the abstract HPA* route and only turn the next leg of it into tiles once they get there
+struct overworld_march
+{
+    vec2i destination = {0, 0};
+
+    std::optional<hierarchical_path> route;
+    ///the tiles being walked right now, leg[leg_next] is the next step
+    std::vector<vec2i> leg;
+    int leg_next = 1;
+
+    float time_between_steps = 0.2f;
+    float time_left = time_between_steps;
+};
+
+///marches further than this go through the cluster graph, anything shorter is a plain A* with the landmark bound
+constexpr int hierarchical_march_distance = path_hierarchy::cluster_size * 2;
+
+///false if there's no way there
+bool order_march(entt::registry& registry, tilemap& tmap, entt::entity army, vec2i destination);
+///right clicking with an army selected sends it there, and everyone already on the march takes their next step
+///call before the tilemap renders, which is what clears the selection on a right click
+void update_overworld_armies(entt::registry& registry, tilemap& tmap, render_window& win, camera& cam, vec2f mpos, float delta_time);
 
 entt::entity create_overworld_unit(entt::registry& registry, sprite_handle handle, tilemap_position transform);
 void debug_overworld(entt::registry& registry, entt::entity en, random_state& rng);
@@ -0,0 +1,463 @@
+#include "overworld_streaming.hpp"
+
+#include <algorithm>
+#include <math.h>
+#include <optional>
+#include <toolkit/render_window.hpp>
+#include "noise.hpp"
+#include "camera.hpp"
+#include "entity_common.hpp"
+#include "sprite_renderer.hpp"
+#include "overworld_building.hpp"
+
+namespace
+{
+    std::pair<int, int> key_of(vec2i coord)
+    {
+        return {coord.x(), coord.y()};
+    }
+
+    int floor_div(int a, int b)
+    {
+        return (a >= 0) ? a / b : -((-a + b - 1) / b);
+    }
+
+    ///nearest plain grass to pos within max_distance, same test as the full overworld's castles minus the landmass check
+    ///checks one tile at a time straight from the noise, so nothing needs to be loaded
+    std::optional<vec2i> find_grass(const chunk_source& src, vec2i pos, int max_distance)
+    {
+        auto is_grass = [&](vec2i at)
+        {
+            if(at.x() < 0 || at.y() < 0 || at.x() >= src.world_dim.x() || at.y() >= src.world_dim.y())
+                return false;
+
+            terrain_tile tile;
+            generate_terrain_row(src.rng, *src.noise, src.world_dim, at, 1, &tile);
+
+            return tile.coll.cost == 1;
+        };
+
+        for(int radius = 0; radius <= max_distance; radius++)
+        {
+            for(int y = -radius; y <= radius; y++)
+            {
+                for(int x = -radius; x <= radius; x++)
+                {
+                    if(std::max(abs(x), abs(y)) != radius)
+                        continue;
+
+                    if(is_grass(pos + vec2i{x, y}))
+                        return pos + vec2i{x, y};
+                }
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    std::vector<overworld_landmark> place_landmarks(const chunk_source& src)
+    {
+        int factions = 6;
+
+        vec2f fcentre = vec2f{src.world_dim.x(), src.world_dim.y()} / 2.f;
+
+        float faction_radius = (src.world_dim.x() * 0.3) * 5.f / factions;
+
+        std::vector<overworld_landmark> ret;
+
+        ///one castle in the middle and the rest in a ring round it, where the full overworld's castles end up after they've pushed each other apart
+        for(int idx = 0; idx < factions; idx++)
+        {
+            vec2f pos = fcentre;
+
+            if(idx > 0)
+            {
+                float rangle = ((float)(idx - 1) / (factions - 1)) * 2 * M_PI;
+
+                pos += vec2f{faction_radius, 0}.rot(rangle);
+            }
+
+            auto found = find_grass(src, {pos.x(), pos.y()}, 64);
+
+            if(!found.has_value())
+            {
+                printf("No room for castle %i\n", idx);
+                continue;
+            }
+
+            overworld_landmark mark;
+            mark.pos = found.value();
+            mark.team = idx;
+            mark.type = tiles::CASTLE_1;
+
+            ret.push_back(mark);
+        }
+
+        return ret;
+    }
+}
+
+vec2i chunk_source::chunk_dim(vec2i coord) const
+{
+    vec2i origin = coord * chunk_size;
+
+    return {std::min(chunk_size, world_dim.x() - origin.x()), std::min(chunk_size, world_dim.y() - origin.y())};
+}
+
+void chunk_workers::start(int num_threads)
+{
+    for(int i = 0; i < num_threads; i++)
+    {
+        threads.emplace_back([this](){run();});
+    }
+}
+
+void chunk_workers::stop()
+{
+    {
+        std::lock_guard guard(lock);
+        quit = true;
+    }
+
+    wake.notify_all();
+
+    for(std::thread& t : threads)
+    {
+        t.join();
+    }
+
+    threads.clear();
+}
+
+void chunk_workers::run()
+{
+    while(true)
+    {
+        vec2i coord;
+
+        {
+            std::unique_lock guard(lock);
+
+            wake.wait(guard, [&](){return quit || queued.size() > 0;});
+
+            if(quit)
+                return;
+
+            coord = queued.front();
+            queued.pop_front();
+        }
+
+        vec2i dim = source->chunk_dim(coord);
+        vec2i origin = coord * source->chunk_size;
+
+        generated_chunk chunk;
+        chunk.coord = coord;
+        chunk.terrain.resize(dim.x() * dim.y());
+
+        for(int y = 0; y < dim.y(); y++)
+        {
+            generate_terrain_row(source->rng, *source->noise, source->world_dim, origin + vec2i{0, y}, dim.x(), &chunk.terrain[y * dim.x()]);
+        }
+
+        std::lock_guard guard(lock);
+        finished.push_back(std::move(chunk));
+    }
+}
+
+chunk_workers::~chunk_workers()
+{
+    stop();
+}
+
+void streamed_overworld::update(entt::registry& registry, render_window& win, const camera& cam)
+{
+    if(!workers)
+    {
+        workers = std::make_shared<chunk_workers>();
+        workers->source = source;
+
+        int num_threads = worker_threads;
+
+        if(num_threads < 0)
+            num_threads = std::max((int)std::thread::hardware_concurrency() - 1, 1);
+
+        workers->start(num_threads);
+    }
+
+    vec2i screen_dim = win.get_window_size();
+
+    vec2f tl = cam.screen_to_tile(win, {0, 0});
+    vec2f br = cam.screen_to_tile(win, {screen_dim.x(), screen_dim.y()});
+
+    vec2i visible_tl = {floor_div((int)floor(tl.x()), chunk_size), floor_div((int)floor(tl.y()), chunk_size)};
+    vec2i visible_br = {floor_div((int)floor(br.x()), chunk_size), floor_div((int)floor(br.y()), chunk_size)};
+
+    vec2i num_chunks = (world_dim + vec2i{chunk_size - 1, chunk_size - 1}) / chunk_size;
+
+    auto within = [&](std::pair<int, int> coord, int margin)
+    {
+        return coord.first >= visible_tl.x() - margin && coord.first <= visible_br.x() + margin &&
+               coord.second >= visible_tl.y() - margin && coord.second <= visible_br.y() + margin;
+    };
+
+    std::vector<vec2i> wanted;
+
+    for(int y = std::max(visible_tl.y() - load_margin, 0); y <= std::min(visible_br.y() + load_margin, num_chunks.y() - 1); y++)
+    {
+        for(int x = std::max(visible_tl.x() - load_margin, 0); x <= std::min(visible_br.x() + load_margin, num_chunks.x() - 1); x++)
+        {
+            std::pair<int, int> key = {x, y};
+
+            if(resident.count(key) > 0 || pending.count(key) > 0)
+                continue;
+
+            wanted.push_back({x, y});
+        }
+    }
+
+    ///whatever's on screen first
+    vec2f centre_chunk = vec2f{visible_tl.x() + visible_br.x(), visible_tl.y() + visible_br.y()} / 2.f;
+
+    std::sort(wanted.begin(), wanted.end(), [&](vec2i a, vec2i b)
+    {
+        return (vec2f{a.x(), a.y()} - centre_chunk).length() < (vec2f{b.x(), b.y()} - centre_chunk).length();
+    });
+
+    std::vector<generated_chunk> arrived;
+
+    {
+        std::lock_guard guard(workers->lock);
+
+        ///the camera's moved on before these got started
+        for(auto it = workers->queued.begin(); it != workers->queued.end();)
+        {
+            if(within(key_of(*it), load_margin))
+            {
+                it++;
+                continue;
+            }
+
+            pending.erase(key_of(*it));
+            it = workers->queued.erase(it);
+        }
+
+        for(vec2i coord : wanted)
+        {
+            workers->queued.push_back(coord);
+            pending.insert(key_of(coord));
+        }
+
+        arrived.swap(workers->finished);
+    }
+
+    if(wanted.size() > 0)
+        workers->wake.notify_all();
+
+    for(generated_chunk& chunk : arrived)
+    {
+        ready.push_back(std::move(chunk));
+    }
+
+    int loaded = 0;
+
+    for(auto it = ready.begin(); it != ready.end();)
+    {
+        std::pair<int, int> key = key_of(it->coord);
+
+        if(!within(key, load_margin))
+        {
+            pending.erase(key);
+            it = ready.erase(it);
+            continue;
+        }
+
+        if(loaded >= max_chunks_per_tick)
+        {
+            it++;
+            continue;
+        }
+
+        pending.erase(key);
+        load(registry, *it);
+        loaded++;
+
+        it = ready.erase(it);
+    }
+
+    std::vector<std::pair<int, int>> too_far;
+
+    for(auto& [key, chunk] : resident)
+    {
+        if(!within(key, evict_margin))
+            too_far.push_back(key);
+    }
+
+    for(auto& key : too_far)
+    {
+        evict(registry, key);
+    }
+}
+
+void streamed_overworld::load(entt::registry& registry, const generated_chunk& chunk)
+{
+    vec2i dim = source->chunk_dim(chunk.coord);
+    vec2i origin = chunk.coord * chunk_size;
+
+    overworld_chunk& loaded = resident[key_of(chunk.coord)];
+    loaded.tmap.create(dim);
+    loaded.tmap.origin = origin;
+
+    for(int y = 0; y < dim.y(); y++)
+    {
+        for(int x = 0; x < dim.x(); x++)
+        {
+            entt::entity en = create_terrain_tile(registry, chunk.terrain[y * dim.x() + x], origin + vec2i{x, y});
+
+            loaded.tmap.add(registry, en, {x, y});
+        }
+    }
+
+    for(int i = 0; i < (int)landmarks.size(); i++)
+    {
+        const overworld_landmark& mark = landmarks[i];
+
+        vec2i local = mark.pos - origin;
+
+        if(!loaded.tmap.in_bounds(local))
+            continue;
+
+        ///same sprite every time the chunk comes back
+        random_state mark_rng = source->rng.fork(rng_stream::LANDMARKS, i);
+
+        sprite_handle handle = get_sprite_handle_of(mark_rng, mark.type);
+        handle.base_colour *= team::colours.at(mark.team);
+
+        tilemap_position trans;
+        trans.pos = mark.pos;
+
+        entt::entity en = create_overworld_building(registry, handle, trans);
+
+        team t;
+        t.t = mark.team;
+
+        registry.assign<team>(en, t);
+
+        loaded.tmap.add(registry, en, local);
+    }
+
+    evicted.erase(key_of(chunk.coord));
+}
+
+void streamed_overworld::evict(entt::registry& registry, std::pair<int, int> coord)
+{
+    auto it = resident.find(coord);
+
+    if(it == resident.end())
+        return;
+
+    tilemap& tmap = it->second.tmap;
+
+    for(auto& cell : tmap.all_entities)
+    {
+        for(entt::entity en : cell)
+        {
+            registry.destroy(en);
+        }
+    }
+
+    remember(coord, std::move(tmap.static_cost));
+
+    resident.erase(it);
+}
+
+void streamed_overworld::remember(std::pair<int, int> coord, std::vector<int16_t> static_cost) const
+{
+    evicted_chunk& cached = evicted[coord];
+    cached.static_cost = std::move(static_cost);
+    cached.last_used = ++evicted_clock;
+
+    ///a few hundred entries at most, so a scan is fine
+    while((int)evicted.size() > std::max(max_evicted, 1))
+    {
+        auto oldest = evicted.begin();
+
+        for(auto it = evicted.begin(); it != evicted.end(); it++)
+        {
+            if(it->second.last_used < oldest->second.last_used)
+                oldest = it;
+        }
+
+        evicted.erase(oldest);
+    }
+}
+
+void streamed_overworld::render(entt::registry& registry, render_window& win, camera& cam, sprite_renderer& renderer, vec2f mpos)
+{
+    for(auto& [key, chunk] : resident)
+    {
+        chunk.tmap.render(registry, win, cam, renderer, mpos);
+    }
+}
+
+int streamed_overworld::cost_at(vec2i pos) const
+{
+    if(pos.x() < 0 || pos.y() < 0 || pos.x() >= world_dim.x() || pos.y() >= world_dim.y())
+        return -1;
+
+    std::pair<int, int> key = {pos.x() / chunk_size, pos.y() / chunk_size};
+    vec2i origin = vec2i{key.first, key.second} * chunk_size;
+    vec2i dim = source->chunk_dim({key.first, key.second});
+
+    int idx = (pos.y() - origin.y()) * dim.x() + (pos.x() - origin.x());
+
+    if(auto it = resident.find(key); it != resident.end())
+        return it->second.tmap.static_cost[idx];
+
+    if(auto it = evicted.find(key); it != evicted.end())
+    {
+        it->second.last_used = ++evicted_clock;
+
+        return it->second.static_cost[idx];
+    }
+
+    ///nothing on a streamed overworld changes the terrain, so what comes out of the seed is what it would have been when it was evicted
+    std::vector<terrain_tile> terrain(dim.x());
+    std::vector<int16_t> static_cost(dim.x() * dim.y());
+
+    for(int y = 0; y < dim.y(); y++)
+    {
+        generate_terrain_row(source->rng, *source->noise, world_dim, origin + vec2i{0, y}, dim.x(), terrain.data());
+
+        for(int x = 0; x < dim.x(); x++)
+        {
+            static_cost[y * dim.x() + x] = (int16_t)std::clamp(terrain[x].coll.cost, -1, (int)INT16_MAX);
+        }
+    }
+
+    int ret = static_cost[idx];
+
+    remember(key, std::move(static_cost));
+
+    return ret;
+}
+
+entt::entity create_streamed_overworld(entt::registry& registry, random_state& rng, vec2i dim)
+{
+    entt::entity res = registry.create();
+
+    auto src = std::make_shared<chunk_source>();
+    src->rng = rng;
+    src->noise = std::make_shared<const noise_data>(create_overworld_noise(rng));
+    src->world_dim = dim;
+
+    streamed_overworld world;
+    world.world_dim = dim;
+    world.chunk_size = src->chunk_size;
+    world.landmarks = place_landmarks(*src);
+    world.source = src;
+
+    registry.assign<streamed_overworld>(res, world);
+    registry.assign<overworld_tag>(res, overworld_tag());
+
+    return res;
+}
@@ -0,0 +1,134 @@
+#ifndef OVERWORLD_STREAMING_HPP_INCLUDED
+#define OVERWORLD_STREAMING_HPP_INCLUDED
+
+#include <vector>
+#include <map>
+#include <set>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+#include <vec/vec.hpp>
+#include <entt/entt.hpp>
+#include "tilemap.hpp"
+#include "random.hpp"
+#include "overworld_generation.hpp"
+
+struct noise_data;
+struct render_window;
+struct camera;
+struct sprite_renderer;
+
+///castles and anything else that has to exist whether or not the ground under it is loaded
+struct overworld_landmark
+{
+    vec2i pos;
+    int team = 0;
+    tiles::type type = tiles::CASTLE_1;
+};
+
+///everything needed to generate any chunk, shared read only with the workers
+struct chunk_source
+{
+    random_state rng;
+    std::shared_ptr<const noise_data> noise;
+    vec2i world_dim = {0, 0};
+    int chunk_size = 32;
+
+    vec2i chunk_dim(vec2i coord) const;
+};
+
+struct generated_chunk
+{
+    vec2i coord;
+    std::vector<terrain_tile> terrain;
+};
+
+///the threads and the queues, shared so that streamed_overworld stays cheap to move around as a component
+struct chunk_workers
+{
+    std::mutex lock;
+    std::condition_variable wake;
+    bool quit = false;
+
+    ///nearest the camera first
+    std::deque<vec2i> queued;
+    std::vector<generated_chunk> finished;
+
+    std::shared_ptr<const chunk_source> source;
+    std::vector<std::thread> threads;
+
+    void start(int num_threads);
+    void stop();
+    void run();
+
+    ~chunk_workers();
+};
+
+///a loaded chunk, real entities in a chunk sized tilemap with its origin set to where it sits in the world
+struct overworld_chunk
+{
+    tilemap tmap;
+};
+
+///an overworld that only exists around the camera
+///terrain is generated a chunk at a time on background threads as the camera gets close, and dropped again once it's far enough away
+///evicted chunks only keep their terrain costs, 2 bytes a tile, and only the most recently used max_evicted of them. The sprites come back bit identical from the seed if the camera returns
+///castles are placed up front from point samples of the noise and kept in landmarks, so startup doesn't depend on world size. Lives on the overworld entity
+struct streamed_overworld
+{
+    int chunk_size = 32;
+    ///chunks this many past the edge of the screen get loaded
+    int load_margin = 1;
+    ///and this many past get evicted. More than load_margin so panning back and forth doesn't thrash
+    int evict_margin = 3;
+    ///-1 for one less than the number of cores
+    int worker_threads = -1;
+    ///spreads the entity creation out when a lot of chunks arrive at once
+    int max_chunks_per_tick = 4;
+    ///evicted chunks whose costs are kept about, past this the least recently used get dropped and regenerated if they're asked for again
+    int max_evicted = 256;
+
+    vec2i world_dim = {0, 0};
+
+    std::shared_ptr<const chunk_source> source;
+    std::shared_ptr<chunk_workers> workers;
+
+    struct evicted_chunk
+    {
+        ///static_cost as it was when the chunk went
+        std::vector<int16_t> static_cost;
+        uint64_t last_used = 0;
+    };
+
+    std::map<std::pair<int, int>, overworld_chunk> resident;
+    ///the compact form. Only a cache, so cost_at is allowed to fill it in
+    mutable std::map<std::pair<int, int>, evicted_chunk> evicted;
+    mutable uint64_t evicted_clock = 0;
+    ///asked for and not loaded yet
+    std::set<std::pair<int, int>> pending;
+    ///generated, waiting for their turn to be turned into entities
+    std::vector<generated_chunk> ready;
+
+    std::vector<overworld_landmark> landmarks;
+
+    ///queues up what's come into view, loads what's arrived, evicts what's too far off
+    void update(entt::registry& registry, render_window& win, const camera& cam);
+    void render(entt::registry& registry, render_window& win, camera& cam, sprite_renderer& renderer, vec2f mpos);
+
+    ///terrain cost at a world tile, whether or not it's loaded. -1 for blocked or off the map
+    ///anything that isn't loaded or cached gets generated on the spot, a chunk at a time
+    int cost_at(vec2i pos) const;
+
+private:
+    ///caches a chunk's costs, dropping the least recently used if that takes it over max_evicted
+    void remember(std::pair<int, int> coord, std::vector<int16_t> static_cost) const;
+    void load(entt::registry& registry, const generated_chunk& chunk);
+    void evict(entt::registry& registry, std::pair<int, int> coord);
+};
+
+entt::entity create_streamed_overworld(entt::registry& registry, random_state& rng, vec2i dim);
+
+#endif // OVERWORLD_STREAMING_HPP_INCLUDED
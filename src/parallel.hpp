@@ -0,0 +1,90 @@
+#ifndef PARALLEL_HPP_INCLUDED
+#define PARALLEL_HPP_INCLUDED
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <exception>
+#include <algorithm>
+
+///calls func(i) for every i in [0, count) spread across threads, and returns once they're all done
+///items are handed out a few at a time as threads free up, so which thread gets what varies run to run
+///func must only write to its own item's output if the result is going to come out the same every time
+///-1 threads for one per core. The first exception thrown by func is rethrown here once the rest have stopped
+template<typename F>
+void parallel_for(int count, int num_threads, const F& func)
+{
+    if(num_threads < 0)
+        num_threads = std::max((int)std::thread::hardware_concurrency(), 1);
+
+    num_threads = std::min(num_threads, count);
+
+    if(num_threads <= 1)
+    {
+        for(int i = 0; i < count; i++)
+        {
+            func(i);
+        }
+
+        return;
+    }
+
+    ///small enough that a slow item doesn't leave everyone else waiting, big enough that the counter isn't hammered
+    int chunk = std::max(count / (num_threads * 8), 1);
+
+    std::atomic_int next{0};
+    std::atomic_bool failed{false};
+    std::exception_ptr error;
+    std::mutex error_lock;
+
+    auto work = [&]()
+    {
+        while(!failed)
+        {
+            int start = next.fetch_add(chunk);
+
+            if(start >= count)
+                return;
+
+            int finish = std::min(start + chunk, count);
+
+            try
+            {
+                for(int i = start; i < finish; i++)
+                {
+                    func(i);
+                }
+            }
+            catch(...)
+            {
+                std::lock_guard guard(error_lock);
+
+                if(!error)
+                    error = std::current_exception();
+
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+
+    ///this thread does its share too
+    for(int i = 0; i < num_threads - 1; i++)
+    {
+        threads.emplace_back(work);
+    }
+
+    work();
+
+    for(std::thread& t : threads)
+    {
+        t.join();
+    }
+
+    if(error)
+        std::rethrow_exception(error);
+}
+
+#endif // PARALLEL_HPP_INCLUDED
@@ -0,0 +1,558 @@
+#include "path_hierarchy.hpp"
+
+#include <algorithm>
+#include "tilemap.hpp"
+
+int path_hierarchy::cluster_of(vec2i pos) const
+{
+    return (pos.y() / cluster_size) * num_clusters.x() + pos.x() / cluster_size;
+}
+
+int path_hierarchy::cluster_of(int idx) const
+{
+    return cluster_of(vec2i{idx % dim.x(), idx / dim.x()});
+}
+
+int path_hierarchy::local_index(int cluster, int idx) const
+{
+    const path_cluster& clus = clusters[cluster];
+
+    int x = idx % dim.x() - clus.origin.x();
+    int y = idx / dim.x() - clus.origin.y();
+
+    return y * clus.size.x() + x;
+}
+
+bool is_passable(const tilemap& tmap, int idx)
+{
+    return tmap.path_cost[idx] != -1;
+}
+
+///calls func(tile_in_lo, tile_in_hi) for every place worth crossing from cluster lo to cluster hi
+///hi must be east, south, south east or south west of lo. Only one crossing is kept per open stretch of border, the rest are
+///reachable along the border from it
+template<typename T>
+void for_each_crossing(const tilemap& tmap, const path_hierarchy& hier, int lo, int hi, const T& func)
+{
+    const path_cluster& a = hier.clusters[lo];
+    const path_cluster& b = hier.clusters[hi];
+
+    int width = tmap.dim.x();
+
+    vec2i a_end = a.origin + a.size - 1;
+
+    ///corners only touch through a single diagonal step
+    if(b.origin.y() > a_end.y() && b.origin.x() > a_end.x())
+    {
+        int ta = a_end.y() * width + a_end.x();
+        int tb = b.origin.y() * width + b.origin.x();
+
+        if(is_passable(tmap, ta) && is_passable(tmap, tb))
+            func(ta, tb);
+
+        return;
+    }
+
+    if(b.origin.y() > a_end.y() && b.origin.x() < a.origin.x())
+    {
+        vec2i b_end = b.origin + b.size - 1;
+
+        int ta = a_end.y() * width + a.origin.x();
+        int tb = b.origin.y() * width + b_end.x();
+
+        if(is_passable(tmap, ta) && is_passable(tmap, tb))
+            func(ta, tb);
+
+        return;
+    }
+
+    ///along is the direction of the border, across points from a into b
+    bool east = b.origin.x() > a_end.x();
+
+    vec2i along = east ? vec2i{0, 1} : vec2i{1, 0};
+    vec2i across = east ? vec2i{1, 0} : vec2i{0, 1};
+
+    vec2i first = east ? vec2i{a_end.x(), a.origin.y()} : vec2i{a.origin.x(), a_end.y()};
+    int len = east ? a.size.y() : a.size.x();
+
+    auto tile_a = [&](int i){vec2i pos = first + along * i; return pos.y() * width + pos.x();};
+    auto tile_b = [&](int i){vec2i pos = first + along * i + across; return pos.y() * width + pos.x();};
+    auto paired = [&](int i){return i >= 0 && i < len && is_passable(tmap, tile_a(i)) && is_passable(tmap, tile_b(i));};
+
+    ///a stretch also ends where the cost of crossing changes, otherwise a cheap crossing can hide behind an expensive one
+    auto crossing_cost = [&](int i){return std::max(tmap.path_cost[tile_a(i)], tmap.path_cost[tile_b(i)]);};
+
+    int run_start = -1;
+
+    for(int i = 0; i <= len; i++)
+    {
+        if(paired(i) && (run_start == -1 || crossing_cost(i) == crossing_cost(run_start)))
+        {
+            if(run_start == -1)
+                run_start = i;
+
+            continue;
+        }
+
+        if(run_start == -1)
+            continue;
+
+        int run_length = i - run_start;
+
+        if(run_length <= 5)
+        {
+            int mid = run_start + run_length / 2;
+
+            func(tile_a(mid), tile_b(mid));
+        }
+        else
+        {
+            func(tile_a(run_start), tile_b(run_start));
+            func(tile_a(i - 1), tile_b(i - 1));
+        }
+
+        run_start = -1;
+
+        ///this tile might be the start of the next stretch
+        if(paired(i))
+            i--;
+    }
+
+    ///diagonal steps through the border which can't be made any other way
+    for(int i = 0; i < len - 1; i++)
+    {
+        if(paired(i) || paired(i + 1))
+            continue;
+
+        if(is_passable(tmap, tile_a(i)) && is_passable(tmap, tile_b(i + 1)))
+            func(tile_a(i), tile_b(i + 1));
+
+        if(is_passable(tmap, tile_a(i + 1)) && is_passable(tmap, tile_b(i)))
+            func(tile_a(i + 1), tile_b(i));
+    }
+}
+
+void path_hierarchy::search_cluster(const tilemap& tmap, int cluster, int source, bool reverse, int target)
+{
+    const path_cluster& clus = clusters[cluster];
+
+    int width = tmap.dim.x();
+    int local_size = clus.size.x() * clus.size.y();
+
+    local_dist.assign(local_size, FLT_MAX);
+    local_from.assign(local_size, -1);
+
+    local_open.resize(cluster_size * cluster_size);
+    local_open.clear();
+
+    if(reverse && !is_passable(tmap, source))
+        return;
+
+    int local_source = local_index(cluster, source);
+
+    local_dist[local_source] = 0;
+    local_open.push_or_decrease(local_source, 0, 0);
+
+    int local_target = target == -1 ? -1 : local_index(cluster, target);
+
+    while(!local_open.empty())
+    {
+        int current = local_open.pop();
+
+        if(current == local_target)
+            return;
+
+        vec2i pos = clus.origin + vec2i{current % clus.size.x(), current / clus.size.x()};
+        int current_cost = tmap.path_cost[pos.y() * width + pos.x()];
+
+        for(int dy = -1; dy <= 1; dy++)
+        {
+            for(int dx = -1; dx <= 1; dx++)
+            {
+                vec2i local = vec2i{current % clus.size.x(), current / clus.size.x()} + vec2i{dx, dy};
+
+                if((dx == 0 && dy == 0) || local.x() < 0 || local.y() < 0 || local.x() >= clus.size.x() || local.y() >= clus.size.y())
+                    continue;
+
+                vec2i next_pos = clus.origin + local;
+                int next_cost = tmap.path_cost[next_pos.y() * width + next_pos.x()];
+
+                if(next_cost == -1)
+                    continue;
+
+                int next = local.y() * clus.size.x() + local.x();
+
+                float step = (dx != 0 && dy != 0) ? (float)M_SQRT2 : 1.f;
+
+                ///going backwards, the cost is for stepping from next into current
+                float found = local_dist[current] + step + (reverse ? current_cost : next_cost);
+
+                if(found >= local_dist[next])
+                    continue;
+
+                local_dist[next] = found;
+                local_from[next] = current;
+
+                local_open.push_or_decrease(next, found, 0);
+            }
+        }
+    }
+}
+
+void path_hierarchy::rebuild_cluster(const tilemap& tmap, int cluster)
+{
+    path_cluster& clus = clusters[cluster];
+
+    for(int idx : clus.nodes)
+    {
+        node_slot[idx] = -1;
+    }
+
+    clus.nodes.clear();
+    clus.links.clear();
+
+    vec2i cpos = {cluster % num_clusters.x(), cluster / num_clusters.x()};
+
+    for(int dy = -1; dy <= 1; dy++)
+    {
+        for(int dx = -1; dx <= 1; dx++)
+        {
+            vec2i opos = cpos + vec2i{dx, dy};
+
+            if((dx == 0 && dy == 0) || opos.x() < 0 || opos.y() < 0 || opos.x() >= num_clusters.x() || opos.y() >= num_clusters.y())
+                continue;
+
+            int other = opos.y() * num_clusters.x() + opos.x();
+
+            auto add_crossing = [&](int mine, int theirs)
+            {
+                if(node_slot[mine] == -1)
+                {
+                    node_slot[mine] = clus.nodes.size();
+                    clus.nodes.push_back(mine);
+                    clus.links.emplace_back();
+                }
+
+                clus.links[node_slot[mine]].push_back(theirs);
+            };
+
+            ///both sides have to agree on where the crossings are, so always scan from the same end
+            if(other > cluster)
+                for_each_crossing(tmap, *this, cluster, other, [&](int lo, int hi){add_crossing(lo, hi);});
+            else
+                for_each_crossing(tmap, *this, other, cluster, [&](int lo, int hi){add_crossing(hi, lo);});
+        }
+    }
+
+    int num = clus.nodes.size();
+
+    clus.costs.assign(num * num, FLT_MAX);
+
+    for(int i = 0; i < num; i++)
+    {
+        search_cluster(tmap, cluster, clus.nodes[i], false);
+
+        for(int j = 0; j < num; j++)
+        {
+            clus.costs[i * num + j] = local_dist[local_index(cluster, clus.nodes[j])];
+        }
+    }
+}
+
+void path_hierarchy::rebuild(const tilemap& tmap)
+{
+    dim = tmap.dim;
+    cost_cursor = tmap.cost_revision();
+
+    num_clusters = (dim + cluster_size - 1) / cluster_size;
+
+    clusters.clear();
+    clusters.resize(num_clusters.x() * num_clusters.y());
+
+    for(int cy = 0; cy < num_clusters.y(); cy++)
+    {
+        for(int cx = 0; cx < num_clusters.x(); cx++)
+        {
+            path_cluster& clus = clusters[cy * num_clusters.x() + cx];
+
+            clus.origin = vec2i{cx, cy} * cluster_size;
+            clus.size = vec2i{std::min(cluster_size, dim.x() - clus.origin.x()), std::min(cluster_size, dim.y() - clus.origin.y())};
+        }
+    }
+
+    node_slot.assign(dim.x() * dim.y(), -1);
+    dirty.assign(clusters.size(), 0);
+
+    for(int i = 0; i < (int)clusters.size(); i++)
+    {
+        rebuild_cluster(tmap, i);
+    }
+}
+
+void path_hierarchy::update(const tilemap& tmap)
+{
+    if(dim != tmap.dim || (int)node_slot.size() != dim.x() * dim.y())
+    {
+        rebuild(tmap);
+        return;
+    }
+
+    bool any_dirty = false;
+
+    bool caught_up = tmap.catch_up_cost_changes(cost_cursor, [&](int idx)
+    {
+        dirty[cluster_of(idx)] = 1;
+        any_dirty = true;
+    });
+
+    if(!caught_up)
+    {
+        rebuild(tmap);
+        return;
+    }
+
+    if(!any_dirty)
+        return;
+
+    ///a changed cluster moves the crossings on its borders, so its neighbours need their nodes redoing too
+    for(int i = 0; i < (int)clusters.size(); i++)
+    {
+        if(dirty[i] != 1)
+            continue;
+
+        vec2i cpos = {i % num_clusters.x(), i / num_clusters.x()};
+
+        for(int dy = -1; dy <= 1; dy++)
+        {
+            for(int dx = -1; dx <= 1; dx++)
+            {
+                vec2i opos = cpos + vec2i{dx, dy};
+
+                if(opos.x() < 0 || opos.y() < 0 || opos.x() >= num_clusters.x() || opos.y() >= num_clusters.y())
+                    continue;
+
+                uint8_t& other = dirty[opos.y() * num_clusters.x() + opos.x()];
+
+                if(other == 0)
+                    other = 2;
+            }
+        }
+    }
+
+    for(int i = 0; i < (int)clusters.size(); i++)
+    {
+        if(dirty[i] == 0)
+            continue;
+
+        rebuild_cluster(tmap, i);
+        dirty[i] = 0;
+    }
+}
+
+std::optional<std::vector<vec2i>> hierarchical_path::refine_next(tilemap& tmap)
+{
+    if(finished())
+        return std::nullopt;
+
+    path_hierarchy& hier = tmap.hierarchy;
+
+    hier.update(tmap);
+
+    vec2i from = waypoints[next_leg];
+    vec2i to = waypoints[next_leg + 1];
+
+    int width = tmap.dim.x();
+    int from_idx = from.y() * width + from.x();
+    int to_idx = to.y() * width + to.x();
+
+    int from_cluster = hier.cluster_of(from_idx);
+
+    ///a crossing between clusters is always a single step
+    if(from_cluster != hier.cluster_of(to_idx))
+    {
+        if(!is_passable(tmap, to_idx))
+            return std::nullopt;
+
+        next_leg++;
+
+        return std::vector<vec2i>{from, to};
+    }
+
+    hier.search_cluster(tmap, from_cluster, from_idx, false, to_idx);
+
+    int local = hier.local_index(from_cluster, to_idx);
+
+    if(hier.local_dist[local] == FLT_MAX)
+        return std::nullopt;
+
+    const path_cluster& clus = hier.clusters[from_cluster];
+
+    std::vector<vec2i> ret;
+
+    while(local != -1)
+    {
+        ret.push_back(clus.origin + vec2i{local % clus.size.x(), local / clus.size.x()});
+
+        local = hier.local_from[local];
+    }
+
+    std::reverse(ret.begin(), ret.end());
+
+    next_leg++;
+
+    return ret;
+}
+
+std::optional<hierarchical_path> get_hierarchical_path(tilemap& tmap, vec2i start, vec2i fin)
+{
+    hierarchical_path ret;
+
+    if(start == fin)
+    {
+        ret.waypoints = {start};
+        return ret;
+    }
+
+    path_hierarchy& hier = tmap.hierarchy;
+
+    hier.update(tmap);
+
+    int width = tmap.dim.x();
+    int start_idx = start.y() * width + start.x();
+    int fin_idx = fin.y() * width + fin.x();
+
+    if(!is_passable(tmap, fin_idx))
+        return std::nullopt;
+
+    int start_cluster = hier.cluster_of(start_idx);
+    int fin_cluster = hier.cluster_of(fin_idx);
+
+    ///temporary edges from the start to its cluster's nodes, and from the goal cluster's nodes to the goal
+    std::vector<std::pair<int, float>> start_edges;
+
+    hier.search_cluster(tmap, start_cluster, start_idx, false);
+
+    for(int node : hier.clusters[start_cluster].nodes)
+    {
+        float cost = hier.local_dist[hier.local_index(start_cluster, node)];
+
+        if(cost != FLT_MAX)
+            start_edges.push_back({node, cost});
+    }
+
+    if(start_cluster == fin_cluster)
+    {
+        float cost = hier.local_dist[hier.local_index(start_cluster, fin_idx)];
+
+        if(cost != FLT_MAX)
+            start_edges.push_back({fin_idx, cost});
+    }
+
+    const path_cluster& goal_clus = hier.clusters[fin_cluster];
+
+    std::vector<float> goal_costs;
+
+    hier.search_cluster(tmap, fin_cluster, fin_idx, true);
+
+    for(int node : goal_clus.nodes)
+    {
+        goal_costs.push_back(hier.local_dist[hier.local_index(fin_cluster, node)]);
+    }
+
+    path_search_state& state = tmap.search;
+
+    state.begin(tmap.dim);
+
+    state.seen[start_idx] = state.generation;
+    state.g_score[start_idx] = 0.f;
+    state.came_from[start_idx] = -1;
+
+    state.open.push_or_decrease(start_idx, (start - fin).length(), (start - fin).length());
+
+    while(!state.open.empty())
+    {
+        int current_idx = state.open.pop();
+
+        if(current_idx == fin_idx)
+        {
+            while(current_idx != -1)
+            {
+                ret.waypoints.push_back({current_idx % width, current_idx / width});
+
+                current_idx = state.came_from[current_idx];
+            }
+
+            std::reverse(ret.waypoints.begin(), ret.waypoints.end());
+
+            return ret;
+        }
+
+        state.closed[current_idx] = state.generation;
+
+        float current_g = state.g_score[current_idx];
+
+        auto relax = [&](int next_idx, float cost)
+        {
+            if(state.is_closed(next_idx))
+                return;
+
+            float found_gscore = current_g + cost;
+
+            if(state.is_seen(next_idx) && found_gscore >= state.g_score[next_idx])
+                return;
+
+            state.seen[next_idx] = state.generation;
+            state.came_from[next_idx] = current_idx;
+            state.g_score[next_idx] = found_gscore;
+
+            vec2i next_sys = {next_idx % width, next_idx / width};
+            float h = (next_sys - fin).length();
+
+            state.open.push_or_decrease(next_idx, found_gscore + h, h);
+        };
+
+        if(current_idx == start_idx)
+        {
+            for(auto& [node, cost] : start_edges)
+            {
+                relax(node, cost);
+            }
+        }
+
+        int slot = hier.node_slot[current_idx];
+
+        if(slot == -1)
+            continue;
+
+        int cluster = hier.cluster_of(current_idx);
+        const path_cluster& clus = hier.clusters[cluster];
+        int num = clus.nodes.size();
+
+        for(int j = 0; j < num; j++)
+        {
+            float cost = clus.costs[slot * num + j];
+
+            if(j == slot || cost == FLT_MAX)
+                continue;
+
+            relax(clus.nodes[j], cost);
+        }
+
+        for(int other : clus.links[slot])
+        {
+            int cost = tmap.path_cost[other];
+
+            if(cost == -1)
+                continue;
+
+            bool diagonal = (other % width) != (current_idx % width) && (other / width) != (current_idx / width);
+
+            relax(other, (diagonal ? (float)M_SQRT2 : 1.f) + cost);
+        }
+
+        if(cluster == fin_cluster && goal_costs[slot] != FLT_MAX)
+            relax(fin_idx, goal_costs[slot]);
+    }
+
+    return std::nullopt;
+}
@@ -0,0 +1,78 @@
+#ifndef PATH_HIERARCHY_HPP_INCLUDED
+#define PATH_HIERARCHY_HPP_INCLUDED
+
+#include <vector>
+#include <optional>
+#include <stdint.h>
+#include <vec/vec.hpp>
+#include "pathfinding.hpp"
+
+struct tilemap;
+
+///a square block of tiles. Nodes are the tiles on its border where you can cross into a neighbouring cluster
+struct path_cluster
+{
+    vec2i origin = {0, 0};
+    vec2i size = {0, 0};
+
+    ///tile indices
+    std::vector<int> nodes;
+    ///per node, the tiles in neighbouring clusters you can step to from it
+    std::vector<std::vector<int>> links;
+    ///costs[from * nodes.size() + to], travelling inside this cluster only. FLT_MAX if there's no way
+    std::vector<float> costs;
+};
+
+///HPA* - an abstract graph of cluster entrances over a tilemap, repaired a few clusters at a time as path costs change
+struct path_hierarchy
+{
+    static constexpr int cluster_size = 16;
+
+    vec2i dim = {0, 0};
+    vec2i num_clusters = {0, 0};
+
+    std::vector<path_cluster> clusters;
+    ///per tile, its index in its cluster's node list, or -1
+    std::vector<int> node_slot;
+
+    std::vector<uint8_t> dirty;
+    uint64_t cost_cursor = 0;
+
+    ///scratch for searches confined to a single cluster
+    std::vector<float> local_dist;
+    std::vector<int> local_from;
+    indexed_heap local_open;
+
+    ///brings the graph up to date with the tilemap's path costs
+    void update(const tilemap& tmap);
+
+    int cluster_of(vec2i pos) const;
+    int cluster_of(int idx) const;
+
+    ///dijkstra inside a single cluster. If reverse, local_dist is the cost of getting *to* source
+    ///stops early once target is settled
+    void search_cluster(const tilemap& tmap, int cluster, int source, bool reverse, int target = -1);
+    ///local_dist/local_from index for a tile inside cluster
+    int local_index(int cluster, int idx) const;
+
+private:
+    void rebuild(const tilemap& tmap);
+    void rebuild_cluster(const tilemap& tmap, int cluster);
+};
+
+///an abstract path through cluster entrances, which is turned into tiles one leg at a time
+struct hierarchical_path
+{
+    std::vector<vec2i> waypoints;
+    int next_leg = 0;
+
+    bool finished() const {return next_leg + 1 >= (int)waypoints.size();}
+
+    ///tiles from waypoints[next_leg] to waypoints[next_leg + 1] inclusive
+    ///nullopt if the map has changed so that leg can no longer be walked, and the path needs replanning
+    std::optional<std::vector<vec2i>> refine_next(tilemap& tmap);
+};
+
+std::optional<hierarchical_path> get_hierarchical_path(tilemap& tmap, vec2i start, vec2i fin);
+
+#endif // PATH_HIERARCHY_HPP_INCLUDED
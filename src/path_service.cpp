@@ -0,0 +1,313 @@
+#include "path_service.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include "tilemap.hpp"
+
+const std::vector<int16_t>& cost_snapshot::costs_for(path_cost_policy::type policy) const
+{
+    if(policy == path_cost_policy::STATIC_ONLY)
+        return static_cost;
+
+    return path_cost;
+}
+
+void path_workers::start(int num_threads)
+{
+    for(int i = 0; i < num_threads; i++)
+    {
+        threads.emplace_back([this](){run();});
+    }
+}
+
+void path_workers::stop()
+{
+    {
+        std::lock_guard guard(lock);
+        quit = true;
+    }
+
+    wake.notify_all();
+
+    for(std::thread& t : threads)
+    {
+        t.join();
+    }
+
+    threads.clear();
+}
+
+path_request path_workers::pop_next()
+{
+    auto best = queued.begin();
+
+    for(auto it = queued.begin(); it != queued.end(); it++)
+    {
+        if(it->priority > best->priority)
+            best = it;
+    }
+
+    path_request req = std::move(*best);
+    queued.erase(best);
+
+    return req;
+}
+
+void path_workers::run()
+{
+    ///every worker keeps its own scratch space, tmap.search belongs to the main thread
+    path_search_state state;
+
+    while(true)
+    {
+        path_request req;
+
+        {
+            std::unique_lock guard(lock);
+
+            wake.wait(guard, [&](){return quit || queued.size() > 0;});
+
+            if(quit)
+                return;
+
+            req = pop_next();
+        }
+
+        path_result res;
+        res.revision = req.costs->revision;
+        res.path = get_shortest_path(req.costs->costs_for(req.policy).data(), req.costs->dim, state, req.start, req.finish);
+
+        std::lock_guard guard(req.reply_to->lock);
+        req.reply_to->finished.push_back({req.ticket, std::move(res)});
+    }
+}
+
+std::shared_ptr<path_workers> path_workers::shared()
+{
+    static std::shared_ptr<path_workers> pool = []()
+    {
+        auto ret = std::make_shared<path_workers>();
+        ret->start(std::max((int)std::thread::hardware_concurrency() - 1, 1));
+
+        return ret;
+    }();
+
+    return pool;
+}
+
+path_workers::~path_workers()
+{
+    stop();
+}
+
+void path_service::begin_tick(entt::registry& registry, const tilemap& tmap)
+{
+    if(!workers)
+    {
+        if(worker_threads < 0)
+        {
+            workers = path_workers::shared();
+        }
+        else
+        {
+            workers = std::make_shared<path_workers>();
+            workers->start(worker_threads);
+        }
+
+        inbox = std::make_shared<path_inbox>();
+    }
+
+    std::vector<std::pair<uint64_t, path_result>> arrived;
+
+    {
+        std::lock_guard guard(inbox->lock);
+        arrived.swap(inbox->finished);
+    }
+
+    std::vector<uint64_t> orphaned;
+
+    for(auto& [ticket, owner] : owners)
+    {
+        if(!registry.valid(owner))
+            orphaned.push_back(ticket);
+    }
+
+    for(uint64_t ticket : orphaned)
+    {
+        cancel(ticket);
+    }
+
+    for(auto& [ticket, res] : arrived)
+    {
+        auto it = std::find(cancelled.begin(), cancelled.end(), ticket);
+
+        if(it != cancelled.end())
+        {
+            cancelled.erase(it);
+            continue;
+        }
+
+        delivered[ticket] = std::move(res);
+    }
+
+    if(!snapshot || snapshot->revision != tmap.cost_revision() || snapshot->dim != tmap.dim)
+    {
+        std::shared_ptr<cost_snapshot> next = std::move(back_snapshot);
+
+        ///units move every tick, so usually only a handful of tiles need patching up
+        bool caught_up = next && next.use_count() == 1 && next->dim == tmap.dim && tmap.catch_up_cost_changes(next->revision, [&](int idx)
+        {
+            next->path_cost[idx] = tmap.path_cost[idx];
+            next->static_cost[idx] = tmap.static_cost[idx];
+        });
+
+        ///requests still in flight hold on to the old copy until they're done with it, so anything they're using gets left alone
+        if(!caught_up)
+        {
+            next = std::make_shared<cost_snapshot>();
+            next->dim = tmap.dim;
+            next->revision = tmap.cost_revision();
+            next->path_cost = tmap.path_cost;
+            next->static_cost = tmap.static_cost;
+        }
+
+        back_snapshot = snapshot;
+        snapshot = next;
+    }
+
+    run_slices();
+}
+
+void path_service::run_slices()
+{
+    std::stable_sort(slicing.begin(), slicing.end(), [](const sliced_request& a, const sliced_request& b)
+    {
+        return a.req.priority > b.req.priority;
+    });
+
+    int budget = node_budget;
+
+    ///whatever's most urgent gets first go, and a long search just picks up where it left off next tick
+    for(sliced_request& sliced : slicing)
+    {
+        if(budget <= 0)
+            break;
+
+        int before = sliced.search.expanded;
+
+        sliced.search.step(budget);
+
+        budget -= sliced.search.expanded - before;
+    }
+
+    for(int i = 0; i < (int)slicing.size(); i++)
+    {
+        sliced_request& sliced = slicing[i];
+
+        if(sliced.search.status == search_status::SEARCHING)
+            continue;
+
+        path_result res;
+        res.revision = sliced.req.costs->revision;
+        res.path = sliced.search.path();
+
+        delivered[sliced.req.ticket] = std::move(res);
+
+        spare.push_back(std::move(sliced.search));
+        slicing.erase(slicing.begin() + i);
+        i--;
+    }
+}
+
+uint64_t path_service::submit(vec2i start, vec2i finish, path_cost_policy::type policy, int priority, entt::entity owner)
+{
+    if(!snapshot)
+        throw std::runtime_error("Path submitted before begin_tick");
+
+    if(start.x() < 0 || start.y() < 0 || start.x() >= snapshot->dim.x() || start.y() >= snapshot->dim.y() ||
+       finish.x() < 0 || finish.y() < 0 || finish.x() >= snapshot->dim.x() || finish.y() >= snapshot->dim.y())
+        throw std::runtime_error("Path request out of bounds");
+
+    path_request req;
+    req.ticket = next_ticket++;
+    req.start = start;
+    req.finish = finish;
+    req.policy = policy;
+    req.priority = priority;
+    req.costs = snapshot;
+    req.reply_to = inbox;
+
+    if(owner != entt::null)
+        owners[req.ticket] = owner;
+
+    if(workers->threads.size() == 0)
+    {
+        sliced_request sliced;
+
+        if(spare.size() > 0)
+        {
+            sliced.search = std::move(spare.back());
+            spare.pop_back();
+        }
+
+        sliced.search.begin(req.costs->costs_for(policy).data(), req.costs->dim, start, finish);
+        sliced.req = std::move(req);
+
+        slicing.push_back(std::move(sliced));
+
+        return next_ticket - 1;
+    }
+
+    {
+        std::lock_guard guard(workers->lock);
+        workers->queued.push_back(std::move(req));
+    }
+
+    workers->wake.notify_one();
+
+    return next_ticket - 1;
+}
+
+std::optional<path_result> path_service::take(uint64_t ticket)
+{
+    auto it = delivered.find(ticket);
+
+    if(it == delivered.end())
+        return std::nullopt;
+
+    path_result res = std::move(it->second);
+    delivered.erase(it);
+    owners.erase(ticket);
+
+    return res;
+}
+
+void path_service::cancel(uint64_t ticket)
+{
+    owners.erase(ticket);
+
+    if(delivered.erase(ticket) > 0)
+        return;
+
+    auto sliced_it = std::find_if(slicing.begin(), slicing.end(), [&](const sliced_request& sliced){return sliced.req.ticket == ticket;});
+
+    if(sliced_it != slicing.end())
+    {
+        spare.push_back(std::move(sliced_it->search));
+        slicing.erase(sliced_it);
+        return;
+    }
+
+    std::lock_guard guard(workers->lock);
+
+    ///tickets are only unique within a service, and the queue might be shared
+    auto queued_it = std::find_if(workers->queued.begin(), workers->queued.end(), [&](const path_request& req){return req.ticket == ticket && req.reply_to == inbox;});
+
+    if(queued_it != workers->queued.end())
+    {
+        workers->queued.erase(queued_it);
+        return;
+    }
+
+    cancelled.push_back(ticket);
+}
@@ -0,0 +1,143 @@
+#ifndef PATH_SERVICE_HPP_INCLUDED
+#define PATH_SERVICE_HPP_INCLUDED
+
+#include <vector>
+#include <map>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+#include <vec/vec.hpp>
+#include "pathfinding.hpp"
+
+struct tilemap;
+
+namespace path_cost_policy
+{
+    enum type
+    {
+        ///everything in the way counts, units included
+        ALL,
+        ///only terrain and scenery, for planning through crowds that will have moved by the time we get there
+        STATIC_ONLY,
+    };
+}
+
+///a copy of a tilemap's cost grids, shared read only between the workers
+struct cost_snapshot
+{
+    vec2i dim = {0, 0};
+    ///tmap.cost_revision() when the copy was taken
+    uint64_t revision = 0;
+
+    std::vector<int16_t> path_cost;
+    std::vector<int16_t> static_cost;
+
+    const std::vector<int16_t>& costs_for(path_cost_policy::type policy) const;
+};
+
+struct path_result
+{
+    ///empty if there's no way there
+    std::vector<vec2i> path;
+    ///the revision of the snapshot this was planned against
+    uint64_t revision = 0;
+};
+
+///where a service's finished requests end up, shared with the workers
+struct path_inbox
+{
+    std::mutex lock;
+    std::vector<std::pair<uint64_t, path_result>> finished;
+};
+
+struct path_request
+{
+    uint64_t ticket = 0;
+    vec2i start;
+    vec2i finish;
+    path_cost_policy::type policy = path_cost_policy::ALL;
+    ///higher goes first
+    int priority = 0;
+    std::shared_ptr<const cost_snapshot> costs;
+    std::shared_ptr<path_inbox> reply_to;
+};
+
+///a request being worked through a slice at a time on the main thread
+struct sliced_request
+{
+    path_request req;
+    resumable_search search;
+};
+
+///the threads and the queue, shared so that path_service stays cheap to move around as a component
+///results go back to whichever service's inbox the request came from, so any number of services can feed one set of workers
+struct path_workers
+{
+    std::mutex lock;
+    std::condition_variable wake;
+    bool quit = false;
+
+    std::deque<path_request> queued;
+
+    std::vector<std::thread> threads;
+
+    void start(int num_threads);
+    void stop();
+    void run();
+
+    ///highest priority first, oldest first between equals. Only call with the lock held
+    path_request pop_next();
+
+    ///one less than the number of cores, started the first time anything asks for it and shared by every service in the process
+    ///so running several battles at once doesn't multiply the threads
+    static std::shared_ptr<path_workers> shared();
+
+    ~path_workers();
+};
+
+///pathfinding off the main thread. Submit a query, get a ticket, and pick the result up on a later tick
+///results only show up in begin_tick, so everything a tick sees is stable for the whole tick. Lives on the battle map entity
+///with no worker threads, queries are time sliced instead, sharing node_budget expansions per tick in priority order
+struct path_service
+{
+    ///-1 for the process wide pool, 0 to time slice on the main thread, or a pool of this many threads all of its own
+    int worker_threads = -1;
+    int node_budget = 2048;
+
+    std::shared_ptr<path_workers> workers;
+    std::shared_ptr<path_inbox> inbox;
+    std::shared_ptr<cost_snapshot> snapshot;
+    ///the snapshot before this one. Next time costs change it's caught up from the change log and swapped in, rather than copying the whole map
+    ///unless a search is still using it
+    std::shared_ptr<cost_snapshot> back_snapshot;
+
+    std::vector<sliced_request> slicing;
+    ///finished searches, kept so their scratch space gets reused
+    std::vector<resumable_search> spare;
+
+    uint64_t next_ticket = 1;
+    std::map<uint64_t, path_result> delivered;
+    ///who asked for each ticket that hasn't been taken or cancelled yet, so that tickets belonging to anything that's since been destroyed get thrown away
+    std::map<uint64_t, entt::entity> owners;
+    ///tickets that were given up on before their result came back
+    std::vector<uint64_t> cancelled;
+
+    ///hands over everything the workers finished since last tick, and brings the snapshot up to date if the costs have changed
+    ///when time slicing, this is also where the searching happens
+    ///also cancels anything whose owner has been destroyed, nobody's ever going to come and take it
+    void begin_tick(entt::registry& registry, const tilemap& tmap);
+
+    uint64_t submit(vec2i start, vec2i finish, path_cost_policy::type policy = path_cost_policy::ALL, int priority = 0, entt::entity owner = entt::null);
+    ///the result if it's arrived, after which the ticket is spent
+    std::optional<path_result> take(uint64_t ticket);
+    void cancel(uint64_t ticket);
+
+private:
+    void run_slices();
+};
+
+#endif // PATH_SERVICE_HPP_INCLUDED
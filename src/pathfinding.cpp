@@ -1,27 +1,208 @@
 #include "pathfinding.hpp"
 
-#include <deque>
-#include <set>
+#include <algorithm>
 #include "tilemap.hpp"
-#include "entity_common.hpp"
+#include "search_kernel.hpp"
 
-template<typename T>
-std::vector<T> reconstruct_path(std::map<T, T>& came_from, const T& current)
+void indexed_heap::resize(int size)
+{
+    ///only ever grows, so searches over differently padded grids can share one
+    if((int)slot.size() >= size)
+        return;
+
+    items.clear();
+    key.clear();
+    tiebreak.clear();
+    slot.assign(size, -1);
+}
+
+void indexed_heap::clear()
+{
+    for(int idx : items)
+    {
+        slot[idx] = -1;
+    }
+
+    items.clear();
+    key.clear();
+    tiebreak.clear();
+}
+
+bool indexed_heap::less(int a, int b) const
 {
-    T internal = current;
+    if(key[a] != key[b])
+        return key[a] < key[b];
+
+    ///prefer whichever is closer to the goal
+    return tiebreak[a] < tiebreak[b];
+}
 
-    std::vector<T> total_path{internal};
+void indexed_heap::place(int pos, int idx)
+{
+    items[pos] = idx;
+    slot[idx] = pos;
+}
 
-    while(came_from.find(internal) != came_from.end())
+void indexed_heap::sift_up(int pos)
+{
+    while(pos > 0)
     {
-        internal = came_from[internal];
+        int parent = (pos - 1) / 2;
+
+        if(!less(pos, parent))
+            break;
 
-        total_path.push_back(internal);
+        std::swap(key[pos], key[parent]);
+        std::swap(tiebreak[pos], tiebreak[parent]);
+
+        int a = items[pos];
+        int b = items[parent];
+
+        place(pos, b);
+        place(parent, a);
+
+        pos = parent;
     }
+}
 
-    std::reverse(total_path.begin(), total_path.end());
+void indexed_heap::sift_down(int pos)
+{
+    int len = items.size();
 
-    return total_path;
+    while(true)
+    {
+        int left = pos * 2 + 1;
+        int right = left + 1;
+        int best = pos;
+
+        if(left < len && less(left, best))
+            best = left;
+
+        if(right < len && less(right, best))
+            best = right;
+
+        if(best == pos)
+            break;
+
+        std::swap(key[pos], key[best]);
+        std::swap(tiebreak[pos], tiebreak[best]);
+
+        int a = items[pos];
+        int b = items[best];
+
+        place(pos, b);
+        place(best, a);
+
+        pos = best;
+    }
+}
+
+void indexed_heap::push_or_decrease(int idx, float f, float h)
+{
+    int pos = slot[idx];
+
+    if(pos == -1)
+    {
+        pos = items.size();
+
+        items.push_back(idx);
+        key.push_back(f);
+        tiebreak.push_back(h);
+        slot[idx] = pos;
+    }
+    else
+    {
+        key[pos] = f;
+        tiebreak[pos] = h;
+    }
+
+    sift_up(pos);
+}
+
+int indexed_heap::pop()
+{
+    int top = items[0];
+    int last = items.size() - 1;
+
+    slot[top] = -1;
+    num_popped++;
+
+    if(last > 0)
+    {
+        key[0] = key[last];
+        tiebreak[0] = tiebreak[last];
+        place(0, items[last]);
+    }
+
+    items.pop_back();
+    key.pop_back();
+    tiebreak.pop_back();
+
+    if(items.size() > 0)
+        sift_down(0);
+
+    return top;
+}
+
+void indexed_heap::erase(int idx)
+{
+    int pos = slot[idx];
+
+    if(pos == -1)
+        return;
+
+    int last = items.size() - 1;
+
+    slot[idx] = -1;
+
+    if(pos != last)
+    {
+        key[pos] = key[last];
+        tiebreak[pos] = tiebreak[last];
+        place(pos, items[last]);
+    }
+
+    items.pop_back();
+    key.pop_back();
+    tiebreak.pop_back();
+
+    ///whatever got moved into the hole could belong further up or further down
+    if(pos != last)
+    {
+        int moved = items[pos];
+
+        sift_up(pos);
+        sift_down(slot[moved]);
+    }
+}
+
+void path_search_state::begin(vec2i _dim)
+{
+    int size = _dim.x() * _dim.y();
+
+    ///padded and unpadded searches share this, so it only ever grows. Stale stamps from the other layout are older generations either way
+    dim = _dim;
+
+    if((int)seen.size() < size)
+    {
+        seen.resize(size, 0);
+        closed.resize(size, 0);
+        g_score.resize(size);
+        came_from.resize(size);
+    }
+
+    open.resize(size);
+    open.clear();
+
+    generation++;
+
+    ///on wraparound every stale stamp could alias the new generation
+    if(generation == 0)
+    {
+        std::fill(seen.begin(), seen.end(), 0);
+        std::fill(closed.begin(), closed.end(), 0);
+        generation = 1;
+    }
 }
 
 template<typename T>
@@ -45,140 +226,135 @@ std::optional<T> any_of_a_in_b(const std::vector<T>& a, const std::vector<T>& b)
     return std::nullopt;
 }
 
-///this function was originally designed for an arbitrary linked graph and could be made significantly faster
-template<typename T>
-std::vector<T> get_shortest_path(entt::registry& registry, tilemap& tmap, vec2i start, vec2i fin, int cap = -1)
+std::vector<vec2i> reconstruct_path(const path_search_state& state, int current)
 {
-    std::vector<T> ret;
+    int width = state.dim.x();
 
-    if(start == fin)
+    std::vector<vec2i> total_path;
+
+    while(current != -1)
     {
-        return {start};
-    }
+        total_path.push_back({current % width, current / width});
 
-    std::set<T> closed_set;
-    std::vector<T> open_set = {start};
+        current = state.came_from[current];
+    }
 
-    std::map<T, T> came_from;
+    std::reverse(total_path.begin(), total_path.end());
 
-    std::map<T, float> g_score;
+    return total_path;
+}
 
-    g_score[start] = 0.f;
+std::vector<vec2i> get_shortest_path(const int16_t* costs, vec2i dim, path_search_state& state, vec2i start, vec2i fin, int cap)
+{
+    search_policy::grid_costs grid{costs};
+    search_policy::euclidean h{fin};
 
-    std::deque<std::pair<T, float>> sorted;
+    if(cap == -1)
+        return run_search(grid_search{grid, h}, dim, state, start, fin);
 
-    sorted.push_back({start, 0.f});
+    return run_search(grid_search_capped{grid, h, cap}, dim, state, start, fin);
+}
 
-    int num_explored = 0;
+void resumable_search::begin(const int16_t* _costs, vec2i _dim, vec2i _start, vec2i _fin)
+{
+    costs = _costs;
+    dim = _dim;
+    start = _start;
+    fin = _fin;
+    explored = 0;
+    expanded = 0;
+    status = search_status::SEARCHING;
 
-    while(sorted.size() > 0)
+    if(start == fin)
     {
-        T current_sys = std::move(sorted[0].first);
-
-        sorted.pop_front();
-
-        if(current_sys == fin)
-            return reconstruct_path(came_from, current_sys);
-
-        if(closed_set.find(current_sys) != closed_set.end())
-            continue;
+        status = search_status::FOUND;
+        return;
+    }
 
-        closed_set.insert(current_sys);
+    seed_search(state, dim, start, grid_search{{costs}, {fin}});
+}
 
-        std::vector<std::pair<T, int>> flinks;
-        flinks.reserve(8);
+search_status::type resumable_search::step(int max_nodes)
+{
+    if(status != search_status::SEARCHING)
+        return status;
 
-        auto check_apply = [&](vec2i offset)
-        {
-            if(offset.x() < 0 || offset.y() < 0 || offset.x() >= tmap.dim.x() || offset.y() >= tmap.dim.y())
-                return;
+    status = expand_search(grid_search{{costs}, {fin}}, dim, state, fin, max_nodes, expanded, explored);
 
-            auto& found = tmap.all_entities[offset.y() * tmap.dim.x() + offset.x()];
+    return status;
+}
 
-            int cost = 0;
+std::vector<vec2i> resumable_search::path() const
+{
+    if(status != search_status::FOUND)
+        return {};
 
-            for(entt::entity& i : found)
-            {
-                /*if(!i.passable)
-                    return;*/
+    if(start == fin)
+        return {start};
 
-                if(!registry.has<collidable>(i))
-                    continue;
+    return reconstruct_path(state, fin.y() * dim.x() + fin.x());
+}
 
-                collidable& coll = registry.get<collidable>(i);
+std::vector<vec2i> get_shortest_path(tilemap& tmap, vec2i start, vec2i fin, int cap = -1)
+{
+    tmap.landmarks.update(tmap);
 
-                if(coll.cost == -1)
-                    return;
+    search_policy::padded_costs grid{tmap.padded_cost.data(), tmap.neighbour_offsets};
 
-                cost = std::max(cost, coll.cost);
-            }
+    if(!tmap.landmarks.ready())
+    {
+        search_policy::euclidean h{fin};
 
-            flinks.push_back({offset, cost});
-        };
+        if(cap == -1)
+            return run_search(battle_search{grid, h}, tmap.dim, tmap.search, start, fin);
 
-        check_apply(current_sys + vec2i{-1, 0});
-        check_apply(current_sys + vec2i{1, 0});
-        check_apply(current_sys + vec2i{0, -1});
-        check_apply(current_sys + vec2i{0, 1});
-        check_apply(current_sys + vec2i{-1, -1});
-        check_apply(current_sys + vec2i{1, -1});
-        check_apply(current_sys + vec2i{1, 1});
-        check_apply(current_sys + vec2i{-1, 1});
+        return run_search(battle_search_capped{grid, h, cap}, tmap.dim, tmap.search, start, fin);
+    }
 
-        for(auto& [next_sys, cost] : flinks)
-        {
-            if(closed_set.find(next_sys) != closed_set.end())
-                continue;
+    ///maps with landmarks chosen (the overworld) get the much tighter ALT bound
+    search_policy::landmark h{fin, fin.y() * tmap.dim.x() + fin.x(), &tmap.landmarks};
 
-            auto looking_gscore = g_score.find(next_sys);
-            float found_gscore = g_score[current_sys] + sqrtf((next_sys - current_sys).squared_length()) + cost;
+    if(cap == -1)
+        return run_search(overworld_search{grid, h}, tmap.dim, tmap.search, start, fin);
 
-            float testing_gscore = FLT_MAX;
+    return run_search(overworld_search_capped{grid, h, cap}, tmap.dim, tmap.search, start, fin);
+}
 
-            if(looking_gscore != g_score.end())
-            {
-                testing_gscore = looking_gscore->second;
-            }
+std::optional<std::vector<vec2i>> a_star(tilemap& tmap, vec2i first, vec2i finish, path_mode::type mode)
+{
+    ///already there, which is a one tile path like every search underneath gives back, rather than no path at all
+    if(first == finish)
+        return std::vector<vec2i>{first};
 
-            if(found_gscore >= testing_gscore)
-                continue;
+    ///walled off, no point flooding the whole region to find that out
+    if(!tmap.can_reach(first, finish))
+        return std::nullopt;
 
-            came_from[next_sys] = current_sys;
+    std::vector<vec2i> found;
 
-            g_score[next_sys] = found_gscore;
+    if(mode == path_mode::HIERARCHICAL)
+    {
+        std::optional<hierarchical_path> abstract = get_hierarchical_path(tmap, first, finish);
 
-            sorted.push_back({next_sys, found_gscore + heuristic(next_sys, fin)});
-            //sorted.push_back({next_sys, found_gscore});
+        if(!abstract.has_value())
+            return std::nullopt;
 
-            for(auto& i : sorted)
-            {
-                if(i.first == next_sys)
-                {
-                    i.second = found_gscore + heuristic(next_sys, fin);
-                    //i.second = found_gscore;
-                    break;
-                }
-            }
+        found.push_back(first);
 
-            std::sort(sorted.begin(), sorted.begin(),
-                  [](const std::pair<T, float>& p1, const std::pair<T, float>& p2){return p1.second < p2.second;});
+        while(!abstract.value().finished())
+        {
+            auto leg = abstract.value().refine_next(tmap);
 
-            num_explored++;
+            if(!leg.has_value())
+                return std::nullopt;
 
-            if(num_explored > cap && cap != -1)
-                return ret;
+            found.insert(found.end(), leg.value().begin() + 1, leg.value().end());
         }
     }
-
-    return ret;
-}
-
-std::optional<std::vector<vec2i>> a_star(entt::registry& registry, tilemap& tmap, vec2i first, vec2i finish)
-{
-    if(first == finish)
-        return {};
-
-    auto found = get_shortest_path<vec2i>(registry, tmap, {first}, {finish}, 10000);
+    else if(mode == path_mode::JUMP_POINT)
+        found = get_jump_point_path(tmap, first, finish, -1);
+    else
+        found = get_shortest_path(tmap, {first}, {finish}, -1);
 
     if(found.size() == 0)
         return std::nullopt;
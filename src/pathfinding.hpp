@@ -4,11 +4,118 @@
 #include <vector>
 #include <map>
 #include <optional>
+#include <stdint.h>
 #include <vec/vec.hpp>
 #include <entt/entt.hpp>
 
 struct tilemap;
 
-std::optional<std::vector<vec2i>> a_star(entt::registry& registry, tilemap& tmap, vec2i first, vec2i finish);
+namespace path_mode
+{
+    enum type
+    {
+        ASTAR,
+        ///jump point search, for maps that are mostly one cost. Falls back to A* around anything weighted
+        JUMP_POINT,
+        ///HPA* over clusters of tiles, for long routes. Paths are near optimal rather than optimal
+        HIERARCHICAL,
+    };
+}
+
+///min-heap of tile indices keyed on f score, which supports decrease-key
+///slot[idx] is -1 whenever idx is not in the heap
+struct indexed_heap
+{
+    std::vector<int> items;
+    std::vector<float> key;
+    std::vector<float> tiebreak;
+    std::vector<int> slot;
+
+    ///every pop over the heap's lifetime, so profiling can diff it around a query
+    uint64_t num_popped = 0;
+
+    void resize(int size);
+    void clear();
+
+    bool empty() const {return items.size() == 0;}
+    bool contains(int idx) const {return slot[idx] != -1;}
+
+    void push_or_decrease(int idx, float f, float h);
+    int pop();
+    void erase(int idx);
+
+    ///smallest entry, only valid when not empty
+    int top() const {return items[0];}
+    float top_key() const {return key[0];}
+    float top_tiebreak() const {return tiebreak[0];}
+
+private:
+    bool less(int a, int b) const;
+    void sift_up(int pos);
+    void sift_down(int pos);
+    void place(int pos, int idx);
+};
+
+///dense scratch space for a_star, sized to the biggest grid it's been asked to search
+///everything is stamped with a generation so nothing needs clearing between queries, and nothing gets allocated after the first query
+struct path_search_state
+{
+    vec2i dim = {0, 0};
+    uint32_t generation = 0;
+
+    std::vector<uint32_t> seen;
+    std::vector<uint32_t> closed;
+    std::vector<float> g_score;
+    std::vector<int> came_from;
+
+    indexed_heap open;
+
+    void begin(vec2i _dim);
+
+    bool is_seen(int idx) const {return seen[idx] == generation;}
+    bool is_closed(int idx) const {return closed[idx] == generation;}
+};
+
+namespace search_status
+{
+    enum type
+    {
+        SEARCHING,
+        FOUND,
+        FAILED,
+    };
+}
+
+///A* over a bare cost grid that can stop after a number of expansions and carry on later
+///owns its scratch space, so any number of them can be part way through at once
+struct resumable_search
+{
+    path_search_state state;
+
+    const int16_t* costs = nullptr;
+    vec2i dim = {0, 0};
+    vec2i start = {0, 0};
+    vec2i fin = {0, 0};
+
+    ///tiles popped off the open list so far
+    int expanded = 0;
+    int explored = 0;
+    search_status::type status = search_status::FAILED;
+
+    ///costs has to stay alive until the search is finished
+    void begin(const int16_t* _costs, vec2i _dim, vec2i _start, vec2i _fin);
+    ///expands at most max_nodes tiles
+    search_status::type step(int max_nodes);
+    ///start to fin inclusive once FOUND, empty otherwise
+    std::vector<vec2i> path() const;
+};
+
+///walks came_from back from current, start to current inclusive
+std::vector<vec2i> reconstruct_path(const path_search_state& state, int current);
+
+///plain A* over a bare cost grid (-1 = blocked), so it can run against a copy of the costs off the main thread
+std::vector<vec2i> get_shortest_path(const int16_t* costs, vec2i dim, path_search_state& state, vec2i start, vec2i fin, int cap = -1);
+
+std::optional<std::vector<vec2i>> a_star(tilemap& tmap, vec2i first, vec2i finish, path_mode::type mode = path_mode::ASTAR);
 
 #endif // PATHFINDING_HPP_INCLUDED
@@ -0,0 +1,55 @@
+#include "poisson_disk.hpp"
+
+#include <algorithm>
+
+poisson_disk_sampler::poisson_disk_sampler(vec2f _tl, vec2f _br, float min_radius) : tl(_tl), br(_br)
+{
+    cell_size = std::max(min_radius / (float)M_SQRT2, 0.0001f);
+
+    grid_dim = {(int)ceil((br.x() - tl.x()) / cell_size) + 1, (int)ceil((br.y() - tl.y()) / cell_size) + 1};
+
+    cell_head.assign(grid_dim.x() * grid_dim.y(), -1);
+}
+
+vec2i poisson_disk_sampler::cell_of(vec2f pos) const
+{
+    vec2f rel = (pos - tl) / cell_size;
+
+    return {clamp((int)floor(rel.x()), 0, grid_dim.x() - 1), clamp((int)floor(rel.y()), 0, grid_dim.y() - 1)};
+}
+
+bool poisson_disk_sampler::fits(vec2f pos, float radius) const
+{
+    ///the gap needed is never more than this point's own radius, so that's as far as anything in the way can be
+    int reach = (int)ceil(radius / cell_size);
+
+    vec2i cell = cell_of(pos);
+
+    for(int y = std::max(cell.y() - reach, 0); y <= std::min(cell.y() + reach, grid_dim.y() - 1); y++)
+    {
+        for(int x = std::max(cell.x() - reach, 0); x <= std::min(cell.x() + reach, grid_dim.x() - 1); x++)
+        {
+            for(int idx = cell_head[y * grid_dim.x() + x]; idx != -1; idx = next_in_cell[idx])
+            {
+                float needed = std::min(radius, radii[idx]);
+
+                if((points[idx] - pos).length() < needed)
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void poisson_disk_sampler::add(vec2f pos, float radius)
+{
+    vec2i cell = cell_of(pos);
+    int cell_idx = cell.y() * grid_dim.x() + cell.x();
+
+    points.push_back(pos);
+    radii.push_back(radius);
+    next_in_cell.push_back(cell_head[cell_idx]);
+
+    cell_head[cell_idx] = points.size() - 1;
+}
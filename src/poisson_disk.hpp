@@ -0,0 +1,101 @@
+#ifndef POISSON_DISK_HPP_INCLUDED
+#define POISSON_DISK_HPP_INCLUDED
+
+#include <vector>
+#include <math.h>
+#include <vec/vec.hpp>
+#include "random.hpp"
+
+///Bridson's poisson disk sampling over a rectangle, with a background grid so each candidate only checks the points in nearby cells
+///every point has its own radius, and two points have to be at least the smaller of their radii apart
+///so a town can sit closer to a castle than it can to another town. Deterministic for a given random_state
+struct poisson_disk_sampler
+{
+    vec2f tl;
+    vec2f br;
+
+    ///smallest radius across the grid's diagonal, so a cell can never hold two points that are both sampled
+    float cell_size = 1;
+    vec2i grid_dim = {0, 0};
+
+    ///each cell's points as a linked list through next_in_cell, anything outside the rectangle lands in the nearest edge cell
+    std::vector<int> cell_head;
+    std::vector<int> next_in_cell;
+
+    std::vector<vec2f> points;
+    std::vector<float> radii;
+
+    ///min_radius is the smallest radius any point will have
+    poisson_disk_sampler(vec2f _tl, vec2f _br, float min_radius);
+
+    bool fits(vec2f pos, float radius) const;
+    void add(vec2f pos, float radius);
+
+    ///fills the rectangle and returns the indices of the new points
+    ///accept(vec2f) says whether a spot is usable at all, radius_at(vec2f) is how much room a point there needs
+    ///every time the active list runs dry a fresh seed is tried, so patches cut off by unusable ground still get filled
+    template<typename A, typename R>
+    std::vector<int> sample(random_state& rng, int num_seeds, const A& accept, const R& radius_at, int attempts = 30)
+    {
+        std::vector<int> ret;
+        std::vector<int> active;
+
+        auto try_add = [&](vec2f pos)
+        {
+            if(pos.x() < tl.x() || pos.y() < tl.y() || pos.x() > br.x() || pos.y() > br.y())
+                return false;
+
+            if(!accept(pos))
+                return false;
+
+            float radius = radius_at(pos);
+
+            if(!fits(pos, radius))
+                return false;
+
+            add(pos, radius);
+
+            ret.push_back(points.size() - 1);
+            active.push_back(points.size() - 1);
+
+            return true;
+        };
+
+        for(int seed = 0; seed < num_seeds; seed++)
+        {
+            try_add(round(vec2f{rand_det_s(rng.rng, tl.x(), br.x()), rand_det_s(rng.rng, tl.y(), br.y())}));
+
+            while(active.size() > 0)
+            {
+                int which = clamp((int)rand_det_s(rng.rng, 0, active.size()), 0, (int)active.size() - 1);
+
+                vec2f centre = points[active[which]];
+                float radius = radii[active[which]];
+
+                bool found = false;
+
+                ///candidates from the annulus between r and 2r
+                for(int i = 0; i < attempts && !found; i++)
+                {
+                    float angle = rand_det_s(rng.rng, 0.f, 2 * M_PI);
+                    float len = rand_det_s(rng.rng, radius, radius * 2);
+
+                    found = try_add(round(centre + vec2f{cos(angle), sin(angle)} * len));
+                }
+
+                if(found)
+                    continue;
+
+                active[which] = active.back();
+                active.pop_back();
+            }
+        }
+
+        return ret;
+    }
+
+private:
+    vec2i cell_of(vec2f pos) const;
+};
+
+#endif // POISSON_DISK_HPP_INCLUDED
@@ -2,10 +2,113 @@
 #define RANDOM_HPP_INCLUDED
 
 #include <random>
+#include <stdint.h>
+
+///splitmix64's finaliser, scrambles a counter into something that looks random
+inline uint64_t mix_bits(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+
+    return x;
+}
+
+///stateless counter based generator: number i of a stream is just a hash of (seed, stream, i)
+///so any thread can pick out any number in any order and always get the same answer. SplitMix64 underneath
+///also usable as a normal sequential generator (eg with rand_det_s), index is where it's up to
+struct counter_rng
+{
+    using result_type = uint32_t;
+
+    uint64_t key = 0;
+    uint64_t index = 0;
+
+    counter_rng() = default;
+    counter_rng(uint64_t seed, uint64_t stream) : key(mix_bits(seed ^ mix_bits(stream + 0x9e3779b97f4a7c15ull))) {}
+
+    static constexpr result_type min() {return 0;}
+    static constexpr result_type max() {return UINT32_MAX;}
+
+    uint64_t bits_at(uint64_t i) const
+    {
+        return mix_bits(key + (i + 1) * 0x9e3779b97f4a7c15ull);
+    }
+
+    result_type at(uint64_t i) const
+    {
+        return bits_at(i) >> 32;
+    }
+
+    ///[lo, hi), 24 bits of precision
+    float uniform_at(uint64_t i, float lo, float hi) const
+    {
+        return lo + (hi - lo) * ((bits_at(i) >> 40) * (1.f / 16777216.f));
+    }
+
+    result_type operator()()
+    {
+        return at(index++);
+    }
+
+    ///count numbers starting at first. No iteration depends on another, so this pipelines and vectorises where the target has 64 bit multiplies
+    void fill(uint32_t* out, int count, uint64_t first) const
+    {
+        for(int i = 0; i < count; i++)
+        {
+            out[i] = at(first + i);
+        }
+    }
+
+    void fill_uniform(float* out, int count, uint64_t first, float lo, float hi) const
+    {
+        for(int i = 0; i < count; i++)
+        {
+            out[i] = uniform_at(first + i, lo, hi);
+        }
+    }
+};
+
+///which stream each generator draws from, so adding a new one never shifts what the others get
+namespace rng_stream
+{
+    enum type : uint64_t
+    {
+        TERRAIN_NOISE,
+        TERRAIN_TILES,
+        LANDMARKS,
+    };
+}
 
 struct random_state
 {
     std::minstd_rand rng;
+
+    ///for the counter based streams. Unlike rng, these don't care what's been drawn before
+    uint64_t seed = std::minstd_rand::default_seed;
+
+    ///seeds both, anything that wants a particular world should come through here rather than reseeding rng by itself
+    void set_seed(uint64_t _seed)
+    {
+        seed = _seed;
+        rng.seed(seed % std::minstd_rand::modulus);
+    }
+
+    counter_rng stream(uint64_t id) const
+    {
+        return counter_rng(seed, id);
+    }
+
+    ///a sequential generator of its own for item index of a stream, eg one per tile, for code that wants a random_state
+    random_state fork(uint64_t id, uint64_t index) const
+    {
+        random_state ret;
+        ret.set_seed(stream(id).bits_at(index));
+
+        return ret;
+    }
 };
 
 #endif
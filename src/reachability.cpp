@@ -0,0 +1,270 @@
+#include "reachability.hpp"
+
+#include <algorithm>
+#include "tilemap.hpp"
+
+///clockwise from north, every tile in this ring touches the ones either side of it
+static const vec2i ring[8] = {{0, -1}, {1, -1}, {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}};
+
+bool reachability_index::is_passable(int x, int y) const
+{
+    if(x < 0 || y < 0 || x >= dim.x() || y >= dim.y())
+        return false;
+
+    return label[y * dim.x() + x] != -1;
+}
+
+int reachability_index::find(int l) const
+{
+    while(parent[l] != l)
+    {
+        l = parent[l];
+    }
+
+    return l;
+}
+
+int reachability_index::merge(int a, int b)
+{
+    a = find(a);
+    b = find(b);
+
+    if(a == b)
+        return a;
+
+    ///union by size keeps find shallow without having to compress in a const lookup
+    if(sizes[a] < sizes[b])
+        std::swap(a, b);
+
+    parent[b] = a;
+    sizes[a] += sizes[b];
+
+    return a;
+}
+
+void reachability_index::rebuild(const tilemap& tmap)
+{
+    dim = tmap.dim;
+    cost_cursor = tmap.cost_revision();
+    dirty = false;
+
+    int size = dim.x() * dim.y();
+
+    label.assign(size, -2);
+    parent.clear();
+    sizes.clear();
+
+    for(int idx = 0; idx < size; idx++)
+    {
+        if(tmap.path_cost[idx] == -1)
+            label[idx] = -1;
+    }
+
+    std::vector<int> stack;
+
+    for(int idx = 0; idx < size; idx++)
+    {
+        if(label[idx] != -2)
+            continue;
+
+        int next_label = parent.size();
+
+        parent.push_back(next_label);
+        sizes.push_back(0);
+
+        label[idx] = next_label;
+        stack.push_back(idx);
+
+        while(stack.size() > 0)
+        {
+            int current = stack.back();
+            stack.pop_back();
+
+            sizes[next_label]++;
+
+            int x = current % dim.x();
+            int y = current / dim.x();
+
+            for(const vec2i& offset : ring)
+            {
+                int ox = x + offset.x();
+                int oy = y + offset.y();
+
+                if(ox < 0 || oy < 0 || ox >= dim.x() || oy >= dim.y())
+                    continue;
+
+                int other = oy * dim.x() + ox;
+
+                if(label[other] != -2)
+                    continue;
+
+                label[other] = next_label;
+                stack.push_back(other);
+            }
+        }
+    }
+
+    find_largest();
+}
+
+void reachability_index::open_tile(int idx)
+{
+    int x = idx % dim.x();
+    int y = idx / dim.x();
+
+    int joined = -1;
+
+    for(const vec2i& offset : ring)
+    {
+        if(!is_passable(x + offset.x(), y + offset.y()))
+            continue;
+
+        int other = label[(y + offset.y()) * dim.x() + x + offset.x()];
+
+        joined = joined == -1 ? find(other) : merge(joined, other);
+    }
+
+    if(joined == -1)
+    {
+        joined = parent.size();
+
+        parent.push_back(joined);
+        sizes.push_back(0);
+    }
+
+    label[idx] = joined;
+    sizes[joined]++;
+}
+
+void reachability_index::block_tile(int idx)
+{
+    int x = idx % dim.x();
+    int y = idx / dim.x();
+
+    sizes[find(label[idx])]--;
+    label[idx] = -1;
+
+    if(dirty)
+        return;
+
+    bool open[8] = {};
+
+    for(int i = 0; i < 8; i++)
+    {
+        open[i] = is_passable(x + ring[i].x(), y + ring[i].y());
+    }
+
+    ///the neighbours can only have been split apart if they don't join up around the tile we just blocked
+    ///neighbours in the ring touch each other, and so do orthogonal neighbours a corner apart
+    int groups = 0;
+
+    for(int i = 0; i < 8; i++)
+    {
+        if(!open[i])
+            continue;
+
+        int prev = (i + 7) % 8;
+
+        if(open[prev])
+            continue;
+
+        ///an orthogonal neighbour also touches the previous orthogonal one across the corner
+        if((i % 2) == 0 && open[(i + 6) % 8])
+            continue;
+
+        groups++;
+    }
+
+    ///a fully open ring has no start to count, which is still just the one group
+    if(groups > 1)
+        dirty = true;
+}
+
+void reachability_index::update(const tilemap& tmap)
+{
+    if(dirty || dim != tmap.dim || (int)label.size() != dim.x() * dim.y())
+    {
+        rebuild(tmap);
+        return;
+    }
+
+    bool changed = false;
+
+    bool caught_up = tmap.catch_up_cost_changes(cost_cursor, [&](int idx)
+    {
+        bool passable = tmap.path_cost[idx] != -1;
+
+        if(passable == (label[idx] != -1))
+            return;
+
+        if(passable)
+            open_tile(idx);
+        else
+            block_tile(idx);
+
+        changed = true;
+    });
+
+    ///stale labels from merges pile up over time, and once the history's gone we can't catch up anyway
+    if(!caught_up || dirty || (int)parent.size() > dim.x() * dim.y() * 2)
+    {
+        rebuild(tmap);
+        return;
+    }
+
+    if(changed)
+        find_largest();
+}
+
+int reachability_index::component_of(int idx) const
+{
+    if(label[idx] == -1)
+        return -1;
+
+    return find(label[idx]);
+}
+
+int reachability_index::component_of(vec2i pos) const
+{
+    if(pos.x() < 0 || pos.y() < 0 || pos.x() >= dim.x() || pos.y() >= dim.y())
+        return -1;
+
+    return component_of(pos.y() * dim.x() + pos.x());
+}
+
+void reachability_index::find_largest()
+{
+    largest = -1;
+
+    for(int l = 0; l < (int)parent.size(); l++)
+    {
+        if(parent[l] != l)
+            continue;
+
+        if(largest == -1 || sizes[l] > sizes[largest])
+            largest = l;
+    }
+}
+
+bool reachability_index::can_reach(vec2i start, vec2i fin) const
+{
+    if(start == fin)
+        return true;
+
+    int goal = component_of(fin);
+
+    if(goal == -1)
+        return false;
+
+    if(component_of(start) == goal)
+        return true;
+
+    ///a_star never checks the tile it starts on, so a blocked start can still step out into the goal's region
+    for(const vec2i& offset : ring)
+    {
+        if(component_of(start + offset) == goal)
+            return true;
+    }
+
+    return false;
+}
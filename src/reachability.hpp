@@ -0,0 +1,50 @@
+#ifndef REACHABILITY_HPP_INCLUDED
+#define REACHABILITY_HPP_INCLUDED
+
+#include <vector>
+#include <stdint.h>
+#include <vec/vec.hpp>
+
+struct tilemap;
+
+///labels every walkable tile with the 8-connected region it belongs to, so impossible path queries can be turned down without searching
+///opening a tile merges regions through a union-find over labels. Blocking one only forces a relabel if it could have split a region
+struct reachability_index
+{
+    vec2i dim = {0, 0};
+
+    ///per tile, -1 if blocked. Labels are resolved through parent before they can be compared
+    std::vector<int> label;
+    std::vector<int> parent;
+    ///tile count, only meaningful for root labels
+    std::vector<int> sizes;
+
+    ///root label of the biggest region, -1 if nothing is walkable
+    int largest = -1;
+
+    bool dirty = true;
+    uint64_t cost_cursor = 0;
+
+    ///brings the labels up to date with the tilemap's path costs
+    void update(const tilemap& tmap);
+
+    ///-1 if blocked or off the map
+    int component_of(vec2i pos) const;
+    int component_of(int idx) const;
+    int largest_component() const {return largest;}
+
+    ///whether a_star could find anything from start to fin. The start tile itself doesn't have to be walkable, same as a_star
+    bool can_reach(vec2i start, vec2i fin) const;
+
+private:
+    void rebuild(const tilemap& tmap);
+    void open_tile(int idx);
+    void block_tile(int idx);
+    void find_largest();
+    bool is_passable(int x, int y) const;
+
+    int find(int l) const;
+    int merge(int a, int b);
+};
+
+#endif // REACHABILITY_HPP_INCLUDED
@@ -0,0 +1,208 @@
+#include "road_network.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <map>
+#include "tilemap.hpp"
+#include "entity_common.hpp"
+#include "overworld_building.hpp"
+#include "sprite_renderer.hpp"
+
+namespace
+{
+    struct road_candidate
+    {
+        float cost = FLT_MAX;
+        ///the two tiles either side of the border the road crosses
+        int from = -1;
+        int to = -1;
+    };
+
+    int find_root(std::vector<int>& parent, int i)
+    {
+        while(parent[i] != i)
+        {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+
+        return i;
+    }
+}
+
+std::vector<vec2i> plan_road_network(const tilemap& tmap, const std::vector<vec2i>& settlements)
+{
+    static const vec2i offsets[8] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+
+    vec2i dim = tmap.dim;
+    int size = dim.x() * dim.y();
+
+    std::vector<float> distance(size, FLT_MAX);
+    std::vector<int> came_from(size, -1);
+    std::vector<int> region(size, -1);
+
+    indexed_heap open;
+    open.resize(size);
+
+    for(int i = 0; i < (int)settlements.size(); i++)
+    {
+        if(!tmap.in_bounds(settlements[i]))
+            continue;
+
+        int idx = settlements[i].y() * dim.x() + settlements[i].x();
+
+        if(region[idx] != -1)
+            continue;
+
+        region[idx] = i;
+        distance[idx] = 0;
+        open.push_or_decrease(idx, 0, 0);
+    }
+
+    ///roads follow the terrain, same step costs as a_star
+    auto step_cost = [&](int idx, const vec2i& offset)
+    {
+        return ((offset.x() != 0 && offset.y() != 0) ? (float)M_SQRT2 : 1.f) + tmap.static_cost[idx];
+    };
+
+    while(!open.empty())
+    {
+        int current = open.pop();
+
+        vec2i pos = {current % dim.x(), current / dim.x()};
+
+        for(const vec2i& offset : offsets)
+        {
+            vec2i next = pos + offset;
+
+            if(!tmap.in_bounds(next))
+                continue;
+
+            int next_idx = next.y() * dim.x() + next.x();
+
+            if(tmap.static_cost[next_idx] == -1)
+                continue;
+
+            float found = distance[current] + step_cost(next_idx, offset);
+
+            if(found >= distance[next_idx])
+                continue;
+
+            distance[next_idx] = found;
+            came_from[next_idx] = current;
+            region[next_idx] = region[current];
+            open.push_or_decrease(next_idx, found, 0);
+        }
+    }
+
+    ///the cheapest way across each border between two settlements' regions
+    std::map<std::pair<int, int>, road_candidate> crossings;
+
+    for(int idx = 0; idx < size; idx++)
+    {
+        if(region[idx] == -1)
+            continue;
+
+        vec2i pos = {idx % dim.x(), idx / dim.x()};
+
+        for(const vec2i& offset : offsets)
+        {
+            vec2i next = pos + offset;
+
+            if(!tmap.in_bounds(next))
+                continue;
+
+            int next_idx = next.y() * dim.x() + next.x();
+
+            ///each border gets looked at from both sides, only keep one
+            if(region[next_idx] == -1 || region[next_idx] <= region[idx])
+                continue;
+
+            float cost = distance[idx] + step_cost(next_idx, offset) + distance[next_idx];
+
+            road_candidate& candidate = crossings[{region[idx], region[next_idx]}];
+
+            if(cost >= candidate.cost)
+                continue;
+
+            candidate.cost = cost;
+            candidate.from = idx;
+            candidate.to = next_idx;
+        }
+    }
+
+    std::vector<road_candidate> candidates;
+
+    for(auto& [regions, candidate] : crossings)
+    {
+        candidates.push_back(candidate);
+    }
+
+    std::stable_sort(candidates.begin(), candidates.end(), [](const road_candidate& a, const road_candidate& b){return a.cost < b.cost;});
+
+    ///kruskal over the settlements
+    std::vector<int> parent(settlements.size());
+
+    for(int i = 0; i < (int)parent.size(); i++)
+    {
+        parent[i] = i;
+    }
+
+    std::vector<uint8_t> on_road(size, 0);
+    std::vector<vec2i> ret;
+
+    auto lay = [&](int idx)
+    {
+        ///walks back towards the settlement until it joins road that's already down
+        while(idx != -1 && !on_road[idx])
+        {
+            on_road[idx] = 1;
+            ret.push_back({idx % dim.x(), idx / dim.x()});
+
+            idx = came_from[idx];
+        }
+    };
+
+    for(const road_candidate& candidate : candidates)
+    {
+        int a = find_root(parent, region[candidate.from]);
+        int b = find_root(parent, region[candidate.to]);
+
+        if(a == b)
+            continue;
+
+        parent[a] = b;
+
+        lay(candidate.from);
+        lay(candidate.to);
+    }
+
+    return ret;
+}
+
+void build_roads(entt::registry& registry, tilemap& tmap, const std::vector<vec2i>& road)
+{
+    vec4f road_colour = srgb_to_lin_approx(vec4f{150, 111, 72, 255} / 255.f);
+
+    for(vec2i pos : road)
+    {
+        if(!tmap.in_bounds(pos))
+            continue;
+
+        int idx = pos.y() * tmap.dim.x() + pos.x();
+
+        for(entt::entity en : tmap.all_entities[idx])
+        {
+            ///buildings sit on top of the terrain, it's the ground underneath that becomes road
+            if(!registry.has<collidable>(en) || registry.has<building_tag>(en))
+                continue;
+
+            registry.get<collidable>(en).cost = 0;
+
+            if(registry.has<sprite_handle>(en))
+                registry.get<sprite_handle>(en).base_colour = road_colour;
+        }
+
+        tmap.update_cell_cost(registry, idx);
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef ROAD_NETWORK_HPP_INCLUDED
+#define ROAD_NETWORK_HPP_INCLUDED
+
+#include <vector>
+#include <vec/vec.hpp>
+#include <entt/entt.hpp>
+
+struct tilemap;
+
+///a cheap network of tiles joining every settlement, each road tile listed once
+///mehlhorn's steiner tree approximation: one multi-source dijkstra over the terrain splits the map into regions around each settlement,
+///the cheapest crossing between each pair of touching regions becomes a candidate road, and a minimum spanning tree over those picks which get built
+///within twice the optimal network, for the price of a single search rather than one a_star per pair
+std::vector<vec2i> plan_road_network(const tilemap& tmap, const std::vector<vec2i>& settlements);
+
+///makes the terrain under each road tile free to cross, so armies take to the roads on their own
+void build_roads(entt::registry& registry, tilemap& tmap, const std::vector<vec2i>& road);
+
+#endif // ROAD_NETWORK_HPP_INCLUDED
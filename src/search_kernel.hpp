@@ -0,0 +1,264 @@
+#ifndef SEARCH_KERNEL_HPP_INCLUDED
+#define SEARCH_KERNEL_HPP_INCLUDED
+
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <vec/vec.hpp>
+#include "pathfinding.hpp"
+#include "landmarks.hpp"
+
+///compile time knobs for the A* inner loop
+///every kind of query gets its own copy of the loop with the neighbour set, corner rule, cost lookup, heuristic and cap all baked in
+namespace search_policy
+{
+    ///cardinals first, then diagonals. Same order as the original neighbour list, which keeps tie breaking stable
+    static inline const vec2i offsets[8] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+
+    ///a bare cost grid, -1 = blocked. Every neighbour gets bounds checked
+    struct grid_costs
+    {
+        static constexpr bool padded = false;
+
+        const int16_t* costs = nullptr;
+
+        int operator()(int idx) const {return costs[idx];}
+    };
+
+    ///a tilemap's padded_cost, where the -1 ring round the edge does the bounds checking for free
+    ///indices are padded ones, neighbours is the tilemap's neighbour_offsets
+    struct padded_costs
+    {
+        static constexpr bool padded = true;
+
+        const int16_t* costs = nullptr;
+        const int* neighbours = nullptr;
+
+        int operator()(int idx) const {return costs[idx];}
+    };
+
+    ///straight line distance, which every step is at least as long as
+    struct euclidean
+    {
+        vec2i fin;
+
+        float operator()(vec2i pos, int) const {return (pos - fin).length();}
+    };
+
+    ///only admissible without diagonals, but much tighter than a straight line when that's the case
+    struct manhattan
+    {
+        vec2i fin;
+
+        float operator()(vec2i pos, int) const {return abs(pos.x() - fin.x()) + abs(pos.y() - fin.y());}
+    };
+
+    ///landmark bounds on top of straight line distance, whichever is tighter
+    struct landmark
+    {
+        vec2i fin;
+        int fin_idx = 0;
+        const landmark_table* table = nullptr;
+
+        float operator()(vec2i pos, int idx) const {return std::max((pos - fin).length(), table->lower_bound(idx, fin_idx));}
+    };
+
+    ///CONNECTIVITY is 4 or 8. Without CUT_CORNERS a diagonal step needs both of the cardinals it squeezes between to be open
+    ///CAPPED gives up once cap tiles have been pushed
+    template<typename C, typename H, int CONNECTIVITY = 8, bool CUT_CORNERS = true, bool CAPPED = false>
+    struct policy
+    {
+        static_assert(CONNECTIVITY == 4 || CONNECTIVITY == 8, "Grid searches are 4 or 8 connected");
+
+        static constexpr int connectivity = CONNECTIVITY;
+        static constexpr bool cut_corners = CUT_CORNERS;
+        static constexpr bool capped = CAPPED;
+
+        C cost;
+        H heuristic;
+        int cap = -1;
+    };
+}
+
+///8 way over a bare copy of the costs, for searches that don't have the tilemap to hand
+using grid_search = search_policy::policy<search_policy::grid_costs, search_policy::euclidean>;
+using grid_search_capped = search_policy::policy<search_policy::grid_costs, search_policy::euclidean, 8, true, true>;
+///battle maps, 8 way straight off the tilemap
+using battle_search = search_policy::policy<search_policy::padded_costs, search_policy::euclidean>;
+using battle_search_capped = search_policy::policy<search_policy::padded_costs, search_policy::euclidean, 8, true, true>;
+///the overworld moves the same way, but knows enough about its terrain to use the landmark bound
+using overworld_search = search_policy::policy<search_policy::padded_costs, search_policy::landmark>;
+using overworld_search_capped = search_policy::policy<search_policy::padded_costs, search_policy::landmark, 8, true, true>;
+
+///padded searches run in padded index space, everything else in plain tile indices
+template<typename P>
+int search_stride(vec2i dim)
+{
+    if constexpr(decltype(P::cost)::padded)
+        return dim.x() + 2;
+    else
+        return dim.x();
+}
+
+template<typename P>
+int search_index(vec2i dim, vec2i pos)
+{
+    if constexpr(decltype(P::cost)::padded)
+        return (pos.y() + 1) * (dim.x() + 2) + pos.x() + 1;
+    else
+        return pos.y() * dim.x() + pos.x();
+}
+
+template<typename P>
+void seed_search(path_search_state& state, vec2i dim, vec2i start, const P& p)
+{
+    if constexpr(decltype(P::cost)::padded)
+        state.begin({dim.x() + 2, dim.y() + 2});
+    else
+        state.begin(dim);
+
+    int start_idx = search_index<P>(dim, start);
+
+    state.seen[start_idx] = state.generation;
+    state.g_score[start_idx] = 0.f;
+    state.came_from[start_idx] = -1;
+
+    float start_h = p.heuristic(start, start.y() * dim.x() + start.x());
+
+    state.open.push_or_decrease(start_idx, start_h, start_h);
+}
+
+///pops at most max_expansions tiles off the open list (-1 for no limit), counting them in num_expanded
+///num_explored counts pushes, and carries over between calls for the cap
+template<typename P>
+search_status::type expand_search(const P& p, vec2i dim, path_search_state& state, vec2i fin, int max_expansions, int& num_expanded, int& num_explored)
+{
+    constexpr bool padded = decltype(P::cost)::padded;
+
+    int stride = search_stride<P>(dim);
+    int fin_idx = search_index<P>(dim, fin);
+
+    int neighbours[8];
+
+    for(int i = 0; i < 8; i++)
+    {
+        if constexpr(padded)
+            neighbours[i] = p.cost.neighbours[i];
+        else
+            neighbours[i] = search_policy::offsets[i].y() * stride + search_policy::offsets[i].x();
+    }
+
+    for(int expansions = 0; expansions < max_expansions || max_expansions == -1; expansions++)
+    {
+        if(state.open.empty())
+            return search_status::FAILED;
+
+        int current_idx = state.open.pop();
+
+        num_expanded++;
+
+        if(current_idx == fin_idx)
+            return search_status::FOUND;
+
+        state.closed[current_idx] = state.generation;
+
+        vec2i current_sys = {current_idx % stride, current_idx / stride};
+
+        if constexpr(padded)
+            current_sys = current_sys - vec2i{1, 1};
+
+        float current_g = state.g_score[current_idx];
+
+        for(int i = 0; i < P::connectivity; i++)
+        {
+            vec2i offset = search_policy::offsets[i];
+            vec2i next_sys = current_sys + offset;
+
+            if constexpr(!padded)
+            {
+                if(next_sys.x() < 0 || next_sys.y() < 0 || next_sys.x() >= dim.x() || next_sys.y() >= dim.y())
+                    continue;
+            }
+
+            int next_idx = current_idx + neighbours[i];
+
+            if(state.is_closed(next_idx))
+                continue;
+
+            int cost = p.cost(next_idx);
+
+            if(cost == -1)
+                continue;
+
+            ///both cardinals are in bounds if the diagonal is
+            if constexpr(!P::cut_corners)
+            {
+                if(i >= 4 && (p.cost(current_idx + offset.x()) == -1 || p.cost(current_idx + offset.y() * stride) == -1))
+                    continue;
+            }
+
+            float step = i >= 4 ? (float)M_SQRT2 : 1.f;
+            float found_gscore = current_g + step + cost;
+
+            if(state.is_seen(next_idx) && found_gscore >= state.g_score[next_idx])
+                continue;
+
+            state.seen[next_idx] = state.generation;
+            state.came_from[next_idx] = current_idx;
+            state.g_score[next_idx] = found_gscore;
+
+            float h = p.heuristic(next_sys, next_sys.y() * dim.x() + next_sys.x());
+
+            state.open.push_or_decrease(next_idx, found_gscore + h, h);
+
+            num_explored++;
+
+            if constexpr(P::capped)
+            {
+                if(num_explored > p.cap)
+                    return search_status::FAILED;
+            }
+        }
+    }
+
+    return search_status::SEARCHING;
+}
+
+///start to fin inclusive, in tile coordinates whichever index space the search ran in
+template<typename P>
+std::vector<vec2i> search_result(const path_search_state& state, vec2i dim, vec2i fin)
+{
+    std::vector<vec2i> ret = reconstruct_path(state, search_index<P>(dim, fin));
+
+    if constexpr(decltype(P::cost)::padded)
+    {
+        for(vec2i& pos : ret)
+        {
+            pos = pos - vec2i{1, 1};
+        }
+    }
+
+    return ret;
+}
+
+///runs a search to completion, start to fin inclusive or empty if there's no way there
+template<typename P>
+std::vector<vec2i> run_search(const P& p, vec2i dim, path_search_state& state, vec2i start, vec2i fin)
+{
+    if(start == fin)
+    {
+        return {start};
+    }
+
+    seed_search(state, dim, start, p);
+
+    int num_expanded = 0;
+    int num_explored = 0;
+
+    if(expand_search(p, dim, state, fin, -1, num_expanded, num_explored) != search_status::FOUND)
+        return {};
+
+    return search_result<P>(state, dim, fin);
+}
+
+#endif // SEARCH_KERNEL_HPP_INCLUDED
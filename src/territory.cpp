@@ -0,0 +1,135 @@
+#include "territory.hpp"
+
+#include <cfloat>
+#include <stdexcept>
+#include "tilemap.hpp"
+
+void territory_map::build(const tilemap& tmap, const std::vector<vec2i>& positions, const std::vector<int>& teams)
+{
+    if(positions.size() != teams.size())
+        throw std::runtime_error("Every settlement needs a team");
+
+    dim = tmap.dim;
+    sources = positions;
+    source_team = teams;
+
+    int size = dim.x() * dim.y();
+
+    source_of.assign(size, -1);
+    distance.assign(size, FLT_MAX);
+
+    std::vector<int> seeds;
+
+    for(int i = 0; i < (int)sources.size(); i++)
+    {
+        if(!tmap.in_bounds(sources[i]))
+            throw std::runtime_error("Settlement off the map");
+
+        int idx = sources[i].y() * dim.x() + sources[i].x();
+
+        ///two settlements on one tile, first one keeps it
+        if(source_of[idx] != -1)
+            continue;
+
+        source_of[idx] = i;
+        distance[idx] = 0;
+        seeds.push_back(idx);
+    }
+
+    flood(tmap, seeds);
+}
+
+///dijkstra outwards from seeds, only ever taking tiles it gets to more cheaply than whoever has them now
+void territory_map::flood(const tilemap& tmap, const std::vector<int>& seeds)
+{
+    static const vec2i offsets[8] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+
+    open.resize(dim.x() * dim.y());
+    open.clear();
+
+    for(int idx : seeds)
+    {
+        open.push_or_decrease(idx, distance[idx], 0);
+    }
+
+    while(!open.empty())
+    {
+        int current = open.pop();
+
+        vec2i pos = {current % dim.x(), current / dim.x()};
+
+        for(const vec2i& offset : offsets)
+        {
+            vec2i next = pos + offset;
+
+            if(!tmap.in_bounds(next))
+                continue;
+
+            int next_idx = next.y() * dim.x() + next.x();
+
+            ///territory follows the terrain, armies passing through don't change who owns what
+            int cost = tmap.static_cost[next_idx];
+
+            if(cost == -1)
+                continue;
+
+            float step = (offset.x() != 0 && offset.y() != 0) ? (float)M_SQRT2 : 1.f;
+            float found = distance[current] + step + cost;
+
+            if(found >= distance[next_idx])
+                continue;
+
+            distance[next_idx] = found;
+            source_of[next_idx] = source_of[current];
+            open.push_or_decrease(next_idx, found, 0);
+        }
+    }
+}
+
+int territory_map::source_at(vec2i pos) const
+{
+    if(pos.x() < 0 || pos.y() < 0 || pos.x() >= dim.x() || pos.y() >= dim.y())
+        return -1;
+
+    return source_of[pos.y() * dim.x() + pos.x()];
+}
+
+int territory_map::team_at(vec2i pos) const
+{
+    int source = source_at(pos);
+
+    if(source == -1)
+        return -1;
+
+    return source_team[source];
+}
+
+void territory_map::set_team(int source, int team)
+{
+    if(source < 0 || source >= (int)source_team.size())
+        throw std::runtime_error("No such settlement");
+
+    source_team[source] = team;
+}
+
+int territory_map::add_source(const tilemap& tmap, vec2i pos, int team)
+{
+    if(!tmap.in_bounds(pos))
+        throw std::runtime_error("Settlement off the map");
+
+    sources.push_back(pos);
+    source_team.push_back(team);
+
+    int source = sources.size() - 1;
+    int idx = pos.y() * dim.x() + pos.x();
+
+    if(distance[idx] == 0)
+        return source;
+
+    source_of[idx] = source;
+    distance[idx] = 0;
+
+    flood(tmap, {idx});
+
+    return source;
+}
@@ -0,0 +1,43 @@
+#ifndef TERRITORY_HPP_INCLUDED
+#define TERRITORY_HPP_INCLUDED
+
+#include <vector>
+#include <stdint.h>
+#include <vec/vec.hpp>
+#include "pathfinding.hpp"
+
+struct tilemap;
+
+///which settlement every tile falls under, by cheapest travel over the terrain rather than straight line distance
+///built with one multi-source dijkstra from every settlement at once, so it's a single pass over the map however many there are
+///tiles store the settlement rather than the team, so a settlement changing hands is O(1)
+struct territory_map
+{
+    vec2i dim = {0, 0};
+
+    ///per tile, index into sources of whoever it belongs to. -1 if no settlement can get there
+    std::vector<int> source_of;
+    ///travel cost from that settlement, same step costs as a_star
+    std::vector<float> distance;
+
+    std::vector<vec2i> sources;
+    std::vector<int> source_team;
+
+    ///scratch, not serialised
+    indexed_heap open;
+
+    void build(const tilemap& tmap, const std::vector<vec2i>& positions, const std::vector<int>& teams);
+
+    ///-1 for tiles nobody can reach
+    int team_at(vec2i pos) const;
+    int source_at(vec2i pos) const;
+
+    void set_team(int source, int team);
+    ///a new settlement only claims the tiles it's now closest to, returns its index
+    int add_source(const tilemap& tmap, vec2i pos, int team);
+
+private:
+    void flood(const tilemap& tmap, const std::vector<int>& seeds);
+};
+
+#endif // TERRITORY_HPP_INCLUDED
@@ -13,9 +13,9 @@ void add_to(T& in, vec2i loc)
     in.push_back(loc);
 }
 
-std::map<tiles::type, std::vector<vec2i>>& get_locations()
+static std::map<tiles::type, std::vector<vec2i>> build_locations()
 {
-    static std::map<tiles::type, std::vector<vec2i>> ret;
+    std::map<tiles::type, std::vector<vec2i>> ret;
 
     using namespace tiles;
 
@@ -179,15 +179,25 @@ std::map<tiles::type, std::vector<vec2i>>& get_locations()
     return ret;
 }
 
+///built once, terrain generation reads this from several threads at a time
+std::map<tiles::type, std::vector<vec2i>>& get_locations()
+{
+    static std::map<tiles::type, std::vector<vec2i>> ret = build_locations();
+
+    return ret;
+}
+
 sprite_handle get_sprite_handle_of(random_state& rng, tiles::type type)
 {
-    auto& tiles = get_locations();
+    const auto& tiles = get_locations();
 
-    auto& which = tiles[type];
+    auto it = tiles.find(type);
 
-    if(which.size() == 0)
+    if(it == tiles.end() || it->second.size() == 0)
         throw std::runtime_error("No tiles for type " + std::to_string(type));
 
+    const std::vector<vec2i>& which = it->second;
+
     int len = which.size();
 
     int iwhich = (int)rand_det_s(rng.rng, 0, len);
@@ -282,19 +292,110 @@ void tilemap::create(vec2i _dim)
 {
     dim = _dim;
     all_entities.resize(dim.x() * dim.y());
+
+    static_cost.resize(dim.x() * dim.y(), 0);
+    dynamic_cost.resize(dim.x() * dim.y(), 0);
+    path_cost.resize(dim.x() * dim.y(), 0);
+    dynamic_occupancy.resize(dim.x() * dim.y(), 0);
+    cost_changed_at.resize(dim.x() * dim.y(), 0);
+
+    vec2i padded_dim = dim + vec2i{2, 2};
+
+    padded_cost.assign(padded_dim.x() * padded_dim.y(), -1);
+    padded_occupancy.assign(padded_dim.x() * padded_dim.y(), 0);
+
+    for(int y = 0; y < dim.y(); y++)
+    {
+        for(int x = 0; x < dim.x(); x++)
+        {
+            padded_cost[padded_index({x, y})] = path_cost[y * dim.x() + x];
+            padded_occupancy[padded_index({x, y})] = dynamic_occupancy[y * dim.x() + x];
+        }
+    }
+
+    static const vec2i offsets[8] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+
+    for(int i = 0; i < 8; i++)
+    {
+        neighbour_offsets[i] = offsets[i].y() * padded_dim.x() + offsets[i].x();
+    }
+}
+
+bool is_dynamic_occupant(entt::registry& registry, entt::entity en)
+{
+    return registry.has<damageable>(en) || registry.has<unit_group>(en);
 }
 
-void tilemap::add(entt::entity en, vec2i pos)
+int16_t combine_costs(int16_t c1, int16_t c2)
 {
-    if(pos.x() < 0 || pos.y() < 0 || pos.x() >= dim.x() || pos.y() >= dim.y())
+    if(c1 == -1 || c2 == -1)
+        return -1;
+
+    return std::max(c1, c2);
+}
+
+void tilemap::update_cell_cost(entt::registry& registry, int idx)
+{
+    int16_t costs[2] = {0, 0};
+    uint16_t occupancy = 0;
+
+    for(entt::entity en : all_entities[idx])
+    {
+        bool dynamic = is_dynamic_occupant(registry, en);
+
+        if(dynamic)
+            occupancy++;
+
+        if(!registry.has<collidable>(en))
+            continue;
+
+        int16_t cost = (int16_t)clamp(registry.get<collidable>(en).cost, -1, (int)INT16_MAX);
+
+        costs[dynamic] = combine_costs(costs[dynamic], cost);
+    }
+
+    int padded = padded_index({idx % dim.x(), idx / dim.x()});
+
+    bool static_changed = static_cost[idx] != costs[0];
+
+    static_cost[idx] = costs[0];
+    dynamic_cost[idx] = costs[1];
+    dynamic_occupancy[idx] = occupancy;
+    padded_occupancy[padded] = occupancy;
+
+    int16_t next_cost = combine_costs(costs[0], costs[1]);
+
+    ///a unit standing on scenery hides it from path_cost, but anything keeping a copy of static_cost still needs to hear about it
+    if(path_cost[idx] == next_cost && !static_changed)
+        return;
+
+    path_cost[idx] = next_cost;
+    padded_cost[padded] = next_cost;
+
+    ///once the history is bigger than the map, anyone that far behind is better off rebuilding
+    if((int)cost_changes.size() >= std::max(dim.x() * dim.y(), 1024))
+    {
+        cost_changes_start += cost_changes.size();
+        cost_changes.clear();
+    }
+
+    cost_changes.push_back(idx);
+    cost_changed_at[idx] = cost_revision();
+}
+
+void tilemap::add(entt::registry& registry, entt::entity en, vec2i pos)
+{
+    if(!in_bounds(pos))
         throw std::runtime_error("Add out of bounds");
 
     all_entities[pos.y() * dim.x() + pos.x()].push_back(en);
-} 
 
-void tilemap::remove(entt::entity en, vec2i pos)
+    update_cell_cost(registry, pos.y() * dim.x() + pos.x());
+}
+
+void tilemap::remove(entt::registry& registry, entt::entity en, vec2i pos)
 {
-    if (pos.x() < 0 || pos.y() < 0 || pos.x() >= dim.x() || pos.y() >= dim.y()) 
+    if (!in_bounds(pos))
     {
         std::string err = "Remove out of bounds: pos.x(): " + std::to_string(pos.x()) +
             " pos.y(): " + std::to_string(pos.y()) +
@@ -320,14 +421,16 @@ void tilemap::remove(entt::entity en, vec2i pos)
             break;
         }
     }
+
+    update_cell_cost(registry, pos.y() * dim.x() + pos.x());
 }
 
-void tilemap::move(entt::entity en, vec2i from, vec2i to)
+void tilemap::move(entt::registry& registry, entt::entity en, vec2i from, vec2i to)
 {
-    if (from.x() < 0 || from.y() < 0 || from.x() >= dim.x() || from.y() >= dim.y())
+    if (!in_bounds(from))
         throw std::runtime_error("From out of bounds");
 
-    if (to.x() < 0 || to.y() < 0 || to.x() >= dim.x() || to.y() >= dim.y())
+    if (!in_bounds(to))
         throw std::runtime_error("To out of bounds");
 
     std::vector<entt::entity>& lst = all_entities[from.y() * dim.x() + from.x()];
@@ -343,9 +446,9 @@ void tilemap::move(entt::entity en, vec2i from, vec2i to)
 
         if (ent == en)
         {
-            remove(ent, from);
+            remove(registry, en, from);
 
-            add(ent, to);
+            add(registry, en, to);
 
             break;
         }
@@ -378,7 +481,7 @@ void tilemap::render(entt::registry& registry, render_window& win, camera& cam,
 
                     mouse_interactable& interact = registry.get<mouse_interactable>(en);
 
-                    if(i_tile == vec2i{x, y})
+                    if(i_tile == origin + vec2i{x, y})
                     {
                         if(mouse_hovering)
                         {
@@ -396,7 +499,7 @@ void tilemap::render(entt::registry& registry, render_window& win, camera& cam,
                 else
                 {
                     //Clicked something unclickable
-                    if(mouse_clicked && i_tile == vec2i{x, y})
+                    if(mouse_clicked && i_tile == origin + vec2i{x, y})
                     {
                         selected = std::nullopt;
                     }
@@ -415,7 +518,7 @@ void tilemap::render(entt::registry& registry, render_window& win, camera& cam,
                     //handle.base_colour.w() *= 0.3;
                 }
 
-                if(mouse_hovering && desc.depress_on_hover && i_tile == vec2i{x, y})
+                if(mouse_hovering && desc.depress_on_hover && i_tile == origin + vec2i{x, y})
                 {
                     if(id > 0)
                     {
@@ -454,9 +557,23 @@ void tilemap::render(entt::registry& registry, render_window& win, camera& cam,
 
 int tilemap::entities_at_position(vec2i pos)
 {
-    if (pos.x() < 0 || pos.y() < 0 || pos.x() >= dim.x() || pos.y() >= dim.y())
+    if (!in_bounds(pos))
         throw std::runtime_error("Out of bounds");
 
     return all_entities[pos.y() * dim.x() + pos.x()].size();
 }
 
+int tilemap::cost_at_position(vec2i pos)
+{
+    if (!in_bounds(pos))
+        throw std::runtime_error("Out of bounds");
+
+    return path_cost[pos.y() * dim.x() + pos.x()];
+}
+
+bool tilemap::can_reach(vec2i start, vec2i fin)
+{
+    reachability.update(*this);
+
+    return reachability.can_reach(start, fin);
+}
@@ -5,8 +5,14 @@
 #include <vec/vec.hpp>
 #include <map>
 #include <optional>
+#include <stdint.h>
 #include "sprite_renderer.hpp"
 #include "random.hpp"
+#include "pathfinding.hpp"
+#include "jump_point_search.hpp"
+#include "path_hierarchy.hpp"
+#include "reachability.hpp"
+#include "landmarks.hpp"
 #include <networking/serialisable_fwd.hpp>
 
 namespace ai_info
@@ -124,16 +130,77 @@ struct tilemap : serialisable, free_function
     std::optional<entt::entity> selected;
 
     vec2i dim;
+    ///where cell {0, 0} sits in the world, nonzero when this is one chunk of a streamed overworld
+    vec2i origin = {0, 0};
     // x * y, back to front rendering
     std::vector<std::vector<entt::entity>> all_entities;
 
+    ///path costs derived from the collidables in each cell, kept up to date by add/remove/move. -1 = blocked
+    ///static is terrain and scenery, dynamic is anything that can move (units, armies)
+    std::vector<int16_t> static_cost;
+    std::vector<int16_t> dynamic_cost;
+    ///both layers combined, this is what pathfinding reads
+    std::vector<int16_t> path_cost;
+    ///number of dynamic entities in each cell
+    std::vector<uint16_t> dynamic_occupancy;
+
+    ///path_cost and dynamic_occupancy again, with a one cell ring round the outside (-1 and 0) so neighbour loops can step off the edge without checking
+    ///(dim.x() + 2) * (dim.y() + 2), index these with padded_index
+    std::vector<int16_t> padded_cost;
+    std::vector<uint16_t> padded_occupancy;
+    ///what to add to a padded index to get each neighbour, same order as the pathfinding offsets
+    int neighbour_offsets[8] = {};
+
+    ///every cell whose path_cost or static_cost changed, oldest first. Anything derived from path_cost keeps a cursor into this and catches up lazily
+    std::vector<int> cost_changes;
+    uint64_t cost_changes_start = 0;
+    ///per cell, the cost_revision() just after its costs last changed
+    std::vector<uint64_t> cost_changed_at;
+
+    ///scratch space reused by a_star, not serialised
+    path_search_state search;
+    jump_point_table jump_points;
+    path_hierarchy hierarchy;
+    reachability_index reachability;
+    landmark_table landmarks;
+
     void create(vec2i dim);
-    void add(entt::entity en, vec2i pos);
-    void remove(entt::entity en, vec2i pos);
-    void move(entt::entity en, vec2i from, vec2i to);
+    void add(entt::registry& registry, entt::entity en, vec2i pos);
+    void remove(entt::registry& registry, entt::entity en, vec2i pos);
+    void move(entt::registry& registry, entt::entity en, vec2i from, vec2i to);
     void render(entt::registry& reg, render_window& win, camera& cam, sprite_renderer& renderer, vec2f mpos);
 
+    bool in_bounds(vec2i pos) const {return pos.x() >= 0 && pos.y() >= 0 && pos.x() < dim.x() && pos.y() < dim.y();}
+    int padded_index(vec2i pos) const {return (pos.y() + 1) * (dim.x() + 2) + pos.x() + 1;}
+
     int entities_at_position(vec2i pos);
+    int cost_at_position(vec2i pos);
+    ///O(1) once the index is up to date, check this before asking a_star for something that might not exist
+    bool can_reach(vec2i start, vec2i fin);
+
+    uint64_t cost_revision() const {return cost_changes_start + cost_changes.size();}
+
+    ///calls func(idx) for every cell that changed since cursor and moves the cursor up to date
+    ///returns false if that history has been discarded, in which case the caller has to rebuild from scratch
+    template<typename T>
+    bool catch_up_cost_changes(uint64_t& cursor, const T& func) const
+    {
+        if(cursor < cost_changes_start)
+        {
+            cursor = cost_revision();
+            return false;
+        }
+
+        for(uint64_t i = cursor - cost_changes_start; i < cost_changes.size(); i++)
+        {
+            func(cost_changes[i]);
+        }
+
+        cursor = cost_revision();
+        return true;
+    }
+
+    void update_cell_cost(entt::registry& registry, int idx);
 };
 
 #endif